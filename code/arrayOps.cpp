@@ -0,0 +1,64 @@
+#include <cstring>
+#include "arrayOps.h"
+#include "symbInfo.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+void ArrayOps::Fill(int64_t* values, uint8_t* types, uint32_t n, int64_t value, uint8_t type) {
+    uint32_t i = 0;
+#ifdef __SSE2__
+    __m128i v = _mm_set1_epi64x(value);
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(values + i), v);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(values + i + 2), v);
+    }
+#endif
+    for (; i < n; ++i) values[i] = value;
+    memset(types, type, n);
+}
+
+void ArrayOps::Copy(int64_t* values, uint8_t* types, const int64_t* srcValues, const uint8_t* srcTypes,
+                    uint32_t n) {
+    memmove(values, srcValues, n * sizeof(int64_t));
+    memmove(types, srcTypes, n);
+}
+
+uint32_t ArrayOps::CharRun(const uint8_t* types, uint32_t n) {
+    uint32_t i = 0;
+#ifdef __SSE2__
+    __m128i chars = _mm_set1_epi8(SymbolInfo::CHAR);
+    for (; i + 16 <= n; i += 16) {
+        __m128i t = _mm_loadu_si128(reinterpret_cast<const __m128i*>(types + i));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(t, chars)));
+        if (mask != 0xFFFF) return i + __builtin_ctz(~mask);
+    }
+#endif
+    while (i < n && types[i] == SymbolInfo::CHAR) ++i;
+    return i;
+}
+
+// 16 values per round: the low bytes are masked out, the low halves of
+// each pair of 64-bit lanes gathered into 32-bit lanes and those packed
+// down to 16 and then 8 bits, which cannot saturate below 256
+void ArrayOps::Narrow(const int64_t* values, uint32_t n, char* out) {
+    uint32_t i = 0;
+#ifdef __SSE2__
+    __m128i low = _mm_set1_epi64x(0xFF);
+    for (; i + 16 <= n; i += 16) {
+        __m128i words[4];
+        for (uint32_t k = 0; k < 4; ++k) {
+            const __m128i* src = reinterpret_cast<const __m128i*>(values + i + 4 * k);
+            __m128i x0 = _mm_and_si128(_mm_loadu_si128(src), low);
+            __m128i x1 = _mm_and_si128(_mm_loadu_si128(src + 1), low);
+            x0 = _mm_shuffle_epi32(x0, _MM_SHUFFLE(3, 1, 2, 0));
+            x1 = _mm_shuffle_epi32(x1, _MM_SHUFFLE(3, 1, 2, 0));
+            words[k] = _mm_unpacklo_epi64(x0, x1);
+        }
+        __m128i lo = _mm_packs_epi32(words[0], words[1]);
+        __m128i hi = _mm_packs_epi32(words[2], words[3]);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(lo, hi));
+    }
+#endif
+    for (; i < n; ++i) out[i] = static_cast<char>(values[i]);
+}
@@ -0,0 +1,22 @@
+#ifndef ARRAYOPS_H
+#define ARRAYOPS_H
+
+#include <cstdint>
+
+// Bulk operations on array elements, which live in consecutive slots of
+// the register file with their runtime types alongside. The loops work on
+// 16 bytes at a time with SSE2 where the compiler targets it and fall back
+// to one element at a time elsewhere.
+class ArrayOps {
+public:
+    static void Fill(int64_t* values, uint8_t* types, uint32_t n, int64_t value, uint8_t type);
+    // The ranges may overlap
+    static void Copy(int64_t* values, uint8_t* types, const int64_t* srcValues, const uint8_t* srcTypes,
+                     uint32_t n);
+    // Number of leading elements of type CHAR
+    static uint32_t CharRun(const uint8_t* types, uint32_t n);
+    // The chars the values print as, the low byte of each
+    static void Narrow(const int64_t* values, uint32_t n, char* out);
+};
+
+#endif
@@ -0,0 +1,250 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstring>
+#include "benchmark.h"
+#include "bytecode.h"
+#include "executor.h"
+#include "pairProfile.h"
+#include "jit.h"
+#include "output.h"
+#include "settings.h"
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Hardware event counter for this process, -1 if the kernel refuses
+static int openCounter(uint32_t type, uint64_t config) {
+#ifdef __linux__
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = type;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+#else
+    return -1;
+#endif
+}
+
+static void startCounter(int fd) {
+#ifdef __linux__
+    if (fd < 0) return;
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+}
+
+static int64_t stopCounter(int fd) {
+    int64_t count = -1;
+#ifdef __linux__
+    if (fd < 0) return -1;
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    if (read(fd, &count, sizeof(count)) != sizeof(count)) count = -1;
+#endif
+    return count;
+}
+
+static std::string counterText(int64_t count) {
+    return count < 0 ? "n/a" : std::to_string(count);
+}
+
+// Stands in for an unbuffered file descriptor: every call that reaches
+// it would be one write system call
+class CountingBuf : public std::streambuf {
+public:
+    uint64_t writes = 0;
+    uint64_t bytes = 0;
+protected:
+    std::streamsize xsputn(const char*, std::streamsize n) override {
+        ++writes;
+        bytes += n;
+        return n;
+    }
+    int overflow(int c) override {
+        ++writes;
+        ++bytes;
+        return c;
+    }
+};
+
+Benchmark::Benchmark(std::vector<Quad>& quads, const std::set<uint64_t>* taggedVars)
+        : quads(quads), taggedVars(taggedVars) {
+    // Constructor
+}
+
+Benchmark::~Benchmark() {
+    // Destructor
+}
+
+Benchmark::Result Benchmark::measure(uint8_t mode, uint32_t runs) {
+    Result result;
+    result.ms = -1;
+    result.l1Misses = -1;
+    result.cacheMisses = -1;
+    result.dispatches = -1;
+
+    int l1 = -1, llc = -1;
+#ifdef __linux__
+    l1 = openCounter(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+                     (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    llc = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+#endif
+
+    std::streambuf* out = std::cout.rdbuf(nullptr);
+    for (uint32_t run = 0; run < runs; ++run) {
+        Executor* executor = new Executor(quads);
+        if (taggedVars != nullptr)
+            executor->SetTaggedVars(*taggedVars);
+        executor->SetThreadedDispatch(mode != MODE_SWITCH);
+        executor->SetSuperinstructions(mode == MODE_FUSED);
+        executor->SetJit(mode == MODE_JIT);
+        executor->SetTiered(mode == MODE_TIERED);
+        std::cin.setstate(std::ios::failbit);
+
+        startCounter(l1);
+        startCounter(llc);
+        auto start = std::chrono::steady_clock::now();
+        if (mode == MODE_QUADS) executor->ExecuteQuads();
+        else executor->Execute();
+        auto end = std::chrono::steady_clock::now();
+        int64_t l1Count = stopCounter(l1);
+        int64_t llcCount = stopCounter(llc);
+        delete executor;
+
+        double ms = std::chrono::duration<double, std::milli>(end - start).count();
+        if (result.ms < 0 || ms < result.ms) {
+            result.ms = ms;
+            result.l1Misses = l1Count;
+            result.cacheMisses = llcCount;
+        }
+    }
+
+    // Counting slows the VM down, so dispatches get a run of their own
+    if (mode != MODE_QUADS && mode != MODE_JIT && mode != MODE_TIERED) {
+        PairProfile* profile = new PairProfile();
+        Executor* executor = new Executor(quads);
+        if (taggedVars != nullptr)
+            executor->SetTaggedVars(*taggedVars);
+        executor->SetSuperinstructions(mode == MODE_FUSED);
+        executor->SetProfile(profile);
+        std::cin.setstate(std::ios::failbit);
+        executor->Execute();
+        result.dispatches = profile->Dispatches();
+        delete executor;
+        delete profile;
+    }
+    std::cout.rdbuf(out);
+    std::cout.clear();
+    std::cin.clear();
+
+#ifdef __linux__
+    if (l1 >= 0) close(l1);
+    if (llc >= 0) close(llc);
+#endif
+    return result;
+}
+
+void Benchmark::Run(uint32_t runs) {
+    // Memory the code occupies: a quad points at separately allocated symbols
+    std::set<const SymbolInfo*> symbols;
+    for (const Quad& q : quads)
+        for (const SymbolInfo* s : {q.op, q.arg1, q.arg2, q.res})
+            if (s != nullptr) symbols.insert(s);
+    uint64_t quadBytes = quads.size() * sizeof(Quad) + symbols.size() * sizeof(SymbolInfo);
+
+    Executor* executor = new Executor(quads);
+    if (taggedVars != nullptr)
+        executor->SetTaggedVars(*taggedVars);
+    executor->SetSuperinstructions(false);
+    Bytecode* lowered = executor->Lower();
+    delete executor;
+    uint64_t codeBytes = lowered->code.size() * sizeof(Instr);
+    uint64_t regBytes = (lowered->slotVars.size() + lowered->constants.size() + lowered->cells) * sizeof(int64_t);
+    uint32_t instrs = lowered->code.size();
+    int64_t jitBytes = -1;
+    Jit* jit = new Jit(*lowered);
+    if (Jit::Supported() && jit->Compile()) jitBytes = jit->CodeSize();
+    delete jit;
+    delete lowered;
+
+    Result results[6];
+    uint8_t lastMode = jitBytes >= 0 ? MODE_TIERED : MODE_FUSED;
+    for (uint8_t mode = MODE_QUADS; mode <= lastMode; ++mode)
+        results[mode] = measure(mode, runs);
+
+    static const char* names[] = { "quads", "switch", "threaded", "fused", "jit", "tiered" };
+    std::cout << "=== Benchmark (best of " << runs << " runs) ===" << std::endl;
+    std::cout << std::left << std::setw(10) << "" << std::right << std::setw(12) << "time (ms)"
+              << std::setw(14) << "dispatches" << std::setw(14) << "L1d misses" << std::setw(14) << "LLC misses"
+              << std::setw(14) << "code bytes" << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+    for (uint8_t mode = MODE_QUADS; mode <= lastMode; ++mode) {
+        const Result& res = results[mode];
+        std::cout << std::left << std::setw(10) << names[mode] << std::right << std::setw(12) << res.ms
+                  << std::setw(14) << counterText(res.dispatches) << std::setw(14) << counterText(res.l1Misses) << std::setw(14) << counterText(res.cacheMisses)
+                  << std::setw(14) << (mode == MODE_QUADS ? quadBytes : mode >= MODE_JIT ? jitBytes : codeBytes)
+                  << std::endl;
+    }
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout << quads.size() << " quads of " << sizeof(Quad) << " bytes and " << symbols.size()
+              << " symbols of " << sizeof(SymbolInfo) << " bytes, " << instrs << " instructions of "
+              << sizeof(Instr) << " bytes and " << regBytes << " bytes of registers" << std::endl;
+    std::cout << std::setprecision(3);
+    if (results[MODE_SWITCH].ms > 0)
+        std::cout << "bytecode vs quads: " << results[MODE_QUADS].ms / results[MODE_SWITCH].ms << "x" << std::endl;
+    if (results[MODE_THREADED].ms > 0)
+        std::cout << "threaded vs switch dispatch: "
+                  << results[MODE_SWITCH].ms / results[MODE_THREADED].ms << "x" << std::endl;
+    if (results[MODE_FUSED].ms > 0)
+        std::cout << "superinstructions vs threaded: " << results[MODE_THREADED].ms / results[MODE_FUSED].ms
+                  << "x, " << results[MODE_FUSED].dispatches << " of " << results[MODE_THREADED].dispatches
+                  << " dispatches" << std::endl;
+    if (lastMode == MODE_TIERED && results[MODE_JIT].ms > 0)
+        std::cout << "jit vs superinstructions: " << results[MODE_FUSED].ms / results[MODE_JIT].ms << "x" << std::endl;
+}
+
+void Benchmark::RunOutput(uint32_t runs) {
+    std::cout << "=== Output Benchmark (best of " << runs << " runs) ===" << std::endl;
+    std::cout << std::left << std::setw(10) << "flush" << std::right << std::setw(12) << "time (ms)"
+              << std::setw(14) << "writes" << std::setw(14) << "bytes" << std::endl;
+    uint64_t unbuffered = 0, buffered = 0;
+    for (uint8_t policy = FLUSH_ALWAYS; policy < FLUSH_POLICIES; ++policy) {
+        double best = -1;
+        CountingBuf sink;
+        for (uint32_t run = 0; run < runs; ++run) {
+            sink.writes = 0;
+            sink.bytes = 0;
+            Executor* executor = new Executor(quads);
+            if (taggedVars != nullptr)
+                executor->SetTaggedVars(*taggedVars);
+            executor->SetFlushPolicy(policy);
+            std::streambuf* out = std::cout.rdbuf(&sink);
+            std::cin.setstate(std::ios::failbit);
+            auto start = std::chrono::steady_clock::now();
+            executor->Execute();
+            auto end = std::chrono::steady_clock::now();
+            std::cout.rdbuf(out);
+            std::cout.clear();
+            std::cin.clear();
+            delete executor;
+            double ms = std::chrono::duration<double, std::milli>(end - start).count();
+            if (best < 0 || ms < best) best = ms;
+        }
+        if (policy == FLUSH_ALWAYS) unbuffered = sink.writes;
+        if (policy == OUTPUT_FLUSH) buffered = sink.writes;
+        std::cout << std::left << std::setw(10) << Output::PolicyName(policy) << std::right
+                  << std::fixed << std::setprecision(3) << std::setw(12) << best
+                  << std::setw(14) << sink.writes << std::setw(14) << sink.bytes << std::endl;
+    }
+    std::cout.unsetf(std::ios::floatfield);
+    if (buffered > 0)
+        std::cout << "writes with \"" << Output::PolicyName(OUTPUT_FLUSH) << "\" vs one per print: "
+                  << buffered << " vs " << unbuffered << std::endl;
+}
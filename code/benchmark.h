@@ -0,0 +1,39 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <set>
+#include <vector>
+#include "synt.h"
+
+// Runs a program with the quad interpreter and with the bytecode VM, using
+// switch and threaded dispatch and with superinstructions, and as machine
+// code from the JIT, directly and after a hot loop (tiered), and compares their run time, dispatches, cache misses
+// and the memory their code takes.
+// Program output is discarded and reads see end of input, so it is meant
+// for programs that terminate without reading input.
+class Benchmark {
+public:
+    // taggedVars as given by the optimizer, nullptr to tag every variable
+    Benchmark(std::vector<Quad>& quads, const std::set<uint64_t>* taggedVars);
+    ~Benchmark();
+    void Run(uint32_t runs);
+    // Runs the bytecode VM under every output flush policy and counts the
+    // writes that reach the output stream
+    void RunOutput(uint32_t runs);
+private:
+    enum Modes { MODE_QUADS, MODE_SWITCH, MODE_THREADED, MODE_FUSED, MODE_JIT, MODE_TIERED };
+
+    struct Result {
+        double ms;            // Best wall time over the runs
+        int64_t l1Misses;     // L1 data cache read misses, -1 if unavailable
+        int64_t cacheMisses;  // Last level cache misses, -1 if unavailable
+        int64_t dispatches;   // Bytecode instructions dispatched, -1 for quads and machine code
+    };
+
+    std::vector<Quad>& quads;
+    const std::set<uint64_t>* taggedVars;
+
+    Result measure(uint8_t mode, uint32_t runs);
+};
+
+#endif
@@ -0,0 +1,304 @@
+#include <iostream>
+#include <iomanip>
+#include "bytecode.h"
+#include "ir.h"
+
+// Set while lowering: the operand is an index into the constant pool
+const uint8_t POOL_A = IMM_A << 2;
+const uint8_t POOL_B = IMM_B << 2;
+
+Bytecode::Bytecode(const std::vector<Quad>& quads, bool tagAll, const std::vector<bool>& tagWrites) {
+    cells = 0;
+    lower(quads, tagAll, tagWrites);
+}
+
+Bytecode::~Bytecode() {
+    // Destructor
+}
+
+uint32_t Bytecode::slot(const SymbolInfo* var) {
+    auto it = slots.find(var->val);
+    if (it != slots.end()) return it->second;
+    uint32_t idx = slotVars.size();
+    slots[var->val] = idx;
+    slotVars.push_back(var->val);
+    return idx;
+}
+
+// Variables become slot indices, constants immediates. Wide constants
+// get a pool entry and are patched to their slot once the number of
+// variables is known.
+void Bytecode::operand(const SymbolInfo* sym, uint8_t immFlag, uint8_t& flags, int32_t& field) {
+    if (isVarSym(sym)) {
+        field = slot(sym);
+        return;
+    }
+    int64_t value = isConstSym(sym) ? static_cast<int64_t>(sym->val) : 0;
+    if (value >= INT32_MIN && value <= INT32_MAX) {
+        field = static_cast<int32_t>(value);
+        flags |= immFlag;
+        return;
+    }
+    auto it = pool.find(value);
+    if (it == pool.end()) {
+        it = pool.insert({value, static_cast<uint32_t>(constants.size())}).first;
+        constants.push_back(value);
+    }
+    field = it->second;
+    flags |= immFlag == IMM_A ? POOL_A : POOL_B;
+}
+
+void Bytecode::emit(uint8_t op, uint8_t flags, uint32_t dst, int32_t a, int32_t b) {
+    Instr in;
+    in.op = op;
+    in.flags = flags;
+    in.pad = 0;
+    in.dst = dst;
+    in.a = a;
+    in.b = b;
+    code.push_back(in);
+}
+
+void Bytecode::emitTyped(uint8_t op, uint8_t flags, uint32_t dst, int32_t a, int32_t b, uint16_t type) {
+    emit(op, flags, dst, a, b);
+    code.back().pad = type;
+}
+
+// Type of the elements an array store or fill writes, 0 when it is the
+// runtime type of the value's slot
+uint16_t Bytecode::elementType(const Quad& q) {
+    if (q.op->val == SymbolInfo::STORE_NUMBER || q.op->val == SymbolInfo::FILL_NUMBER) return SymbolInfo::NUMBER;
+    if (q.op->val == SymbolInfo::STORE_CHAR || q.op->val == SymbolInfo::FILL_CHAR) return SymbolInfo::CHAR;
+    if (isVarSym(q.arg1)) return 0;
+    return q.arg1->code == SymbolInfo::CHAR ? SymbolInfo::CHAR : SymbolInfo::NUMBER;
+}
+
+void Bytecode::lower(const std::vector<Quad>& quads, bool tagAll, const std::vector<bool>& tagWrites) {
+    std::map<uint64_t, uint32_t> labelPos;            // Label -> next instruction
+    std::vector<std::pair<uint32_t, uint64_t>> jumps;  // Jump instruction, label
+
+    for (const Quad& q : quads) {
+        if (!isOp(q, SymbolInfo::ARRAY, SymbolInfo::DECLARE) || arrayIds.count(q.res->val) > 0) continue;
+        ArrayInfo info;
+        info.var = q.res->val;
+        info.base = cells;
+        info.size = static_cast<uint32_t>(q.arg1->val);
+        arrayIds[info.var] = arrays.size();
+        arrays.push_back(info);
+        cells += info.size;
+    }
+
+    for (uint32_t i = 0; i < quads.size(); ++i) {
+        const Quad& q = quads[i];
+        bool tagged = tagAll || tagWrites[i];
+        uint8_t flags = 0;
+        int32_t a = 0, b = 0;
+
+        if (q.op == nullptr) {
+            if (isLabelSym(q.res)) labelPos[q.res->val] = code.size();
+        }
+        else if (isGotoQuad(q)) {
+            if (q.arg1 != nullptr && !isVarSym(q.arg1) && q.arg1->val == 0) continue;
+            jumps.push_back({static_cast<uint32_t>(code.size()), q.res != nullptr ? q.res->val : 0});
+            if (isVarSym(q.arg1)) emit(OP_JNZ, IMM_B, 0, slot(q.arg1), 0);
+            else emit(OP_JMP, IMM_A | IMM_B, 0, 0, 0);
+        }
+        else if (isAssignQuad(q)) {
+            operand(q.arg1, IMM_A, flags, a);
+            uint32_t dst = slot(q.res);
+            emit(OP_MOV, flags | IMM_B, dst, a, 0);
+            if (!tagged) continue;
+            if (isVarSym(q.arg1)) emit(OP_COPY_TYPE, IMM_B, dst, a, 0);
+            else emit(OP_SET_TYPE, IMM_A | IMM_B, dst, q.arg1->code == SymbolInfo::CHAR ?
+                      SymbolInfo::CHAR : SymbolInfo::NUMBER, 0);
+        }
+        else if (isBinaryQuad(q)) {
+            uint8_t op;
+            if (q.op->code == SymbolInfo::OPERATOR) {
+                switch (q.op->val) {
+                    case SymbolInfo::PLUS: op = OP_ADD; break;
+                    case SymbolInfo::MINUS: op = OP_SUB; break;
+                    case SymbolInfo::MULTI: op = OP_MUL; break;
+                    case SymbolInfo::SLASH: op = OP_DIV; break;
+                    case SymbolInfo::SLASH_UNCHECKED: op = OP_DIV_UNCHECKED; break;
+                    case SymbolInfo::LESS: op = OP_LT; break;
+                    default: op = OP_GT; break;
+                }
+            }
+            else {
+                switch (q.op->val) {
+                    case SymbolInfo::LOGICAL_EQUALS: op = OP_EQ; break;
+                    case SymbolInfo::NOT_EQUALS: op = OP_NE; break;
+                    case SymbolInfo::LESS_EQUAL: op = OP_LE; break;
+                    case SymbolInfo::MORE_EQUAL: op = OP_GE; break;
+                    case SymbolInfo::AND: op = OP_AND; break;
+                    default: op = OP_OR; break;
+                }
+            }
+            operand(q.arg1, IMM_A, flags, a);
+            operand(q.arg2, IMM_B, flags, b);
+            uint32_t dst = slot(q.res);
+            emit(op, flags, dst, a, b);
+            if (tagged) emit(OP_SET_TYPE, IMM_A | IMM_B, dst, SymbolInfo::NUMBER, 0);
+        }
+        else if (isPrintQuad(q)) {
+            uint8_t op = OP_PRINT;
+            if (q.op->val == SymbolInfo::PRINT_NUMBER) op = OP_PRINT_NUM;
+            else if (q.op->val == SymbolInfo::PRINT_CHAR) op = OP_PRINT_CHAR;
+            else if (q.arg1 != nullptr && q.arg1->code == SymbolInfo::CHAR) op = OP_PRINT_CHAR;
+            else if (q.arg1 != nullptr && q.arg1->code == SymbolInfo::NUMBER) op = OP_PRINT_LINE;
+            else if (q.arg1 == nullptr) continue;
+            operand(q.arg1, IMM_A, flags, a);
+            emit(op, flags | IMM_B, 0, a, 0);
+        }
+        else if (isReadQuad(q)) {
+            if (!isVarSym(q.res)) {
+                emit(OP_READ_DISCARD, IMM_A | IMM_B, 0, 0, 0);
+                continue;
+            }
+            uint8_t op = OP_READ;
+            if (q.op->val == SymbolInfo::READ_NUMBER) op = OP_READ_NUM;
+            else if (q.op->val == SymbolInfo::READ_CHAR) op = OP_READ_CHAR;
+            emit(op, IMM_A | IMM_B, slot(q.res), 0, 0);
+        }
+        else if (isOp(q, SymbolInfo::CONSOLE, SymbolInfo::SLEEP)) {
+            operand(q.arg1, IMM_A, flags, a);
+            emit(OP_SLEEP, flags | IMM_B, 0, a, 0);
+        }
+        else if (isOp(q, SymbolInfo::CONSOLE, SymbolInfo::YIELD)) {
+            emit(OP_YIELD, IMM_A | IMM_B, 0, 0, 0);
+        }
+        else if (isArrayQuad(q)) {
+            bool load = q.op->val == SymbolInfo::LOAD;
+            uint32_t arr = arrayIds[(load ? q.arg1 : q.res)->val];
+            switch (q.op->val) {
+                case SymbolInfo::DECLARE:
+                    emitTyped(OP_AFILL, IMM_A | IMM_B, arr, 0, 0, SymbolInfo::NUMBER);
+                    break;
+                case SymbolInfo::LOAD:
+                    operand(q.arg2, IMM_B, flags, b);
+                    emit(OP_ALOAD, flags | IMM_A, slot(q.res), arr, b);
+                    break;
+                case SymbolInfo::FILL: case SymbolInfo::FILL_NUMBER: case SymbolInfo::FILL_CHAR:
+                    operand(q.arg1, IMM_A, flags, a);
+                    emitTyped(OP_AFILL, flags | IMM_B, arr, a, 0, elementType(q));
+                    break;
+                case SymbolInfo::COPY:
+                    emit(OP_ACOPY, IMM_A | IMM_B, arr, arrayIds[q.arg1->val], 0);
+                    break;
+                case SymbolInfo::PRINT_RANGE:
+                    operand(q.arg1, IMM_A, flags, a);
+                    operand(q.arg2, IMM_B, flags, b);
+                    emit(OP_APRINT, flags, arr, a, b);
+                    break;
+                default:
+                    operand(q.arg2, IMM_A, flags, a);
+                    operand(q.arg1, IMM_B, flags, b);
+                    emitTyped(OP_ASTORE, flags, arr, a, b, elementType(q));
+                    break;
+            }
+        }
+    }
+
+    emit(OP_HALT, IMM_A | IMM_B, 0, 0, 0);
+
+    // Pool entries follow the variables in the register file, and the
+    // arrays follow the pool
+    uint32_t base = slotVars.size();
+    for (ArrayInfo& info : arrays)
+        info.base += base + constants.size();
+    for (Instr& in : code) {
+        if (in.flags & POOL_A) in.a += base;
+        if (in.flags & POOL_B) in.b += base;
+        in.flags &= IMM_A | IMM_B;
+    }
+
+    // Jumps to missing labels fall through like in the quad interpreter
+    for (const auto& j : jumps) {
+        auto it = labelPos.find(j.second);
+        if (it != labelPos.end()) {
+            code[j.first].dst = it->second;
+        }
+        else {
+            code[j.first].op = OP_JNZ;
+            code[j.first].flags = IMM_A | IMM_B;
+            code[j.first].a = 0;
+            code[j.first].dst = j.first + 1;
+        }
+    }
+}
+
+// Sequences the profile found worth fusing, longest first
+struct Fusion {
+    uint8_t length;
+    uint8_t ops[3];
+    uint8_t fused;
+};
+
+static const std::vector<Fusion>& fusions() {
+#define SUPER_PAIR(x, y) { 2, { OP_##x, OP_##y, 0 }, OP_##x##_##y },
+#define SUPER_TRIPLE(x, y, z) { 3, { OP_##x, OP_##y, OP_##z }, OP_##x##_##y##_##z },
+    static const std::vector<Fusion> table = {
+        SUPER_TRIPLES(SUPER_TRIPLE)
+        SUPER_PAIRS(SUPER_PAIR)
+    };
+#undef SUPER_PAIR
+#undef SUPER_TRIPLE
+    return table;
+}
+
+void Bytecode::Fuse() {
+    std::vector<uint8_t> base(code.size());
+    for (uint32_t i = 0; i < code.size(); ++i) base[i] = code[i].op;
+
+    for (uint32_t i = 0; i < code.size(); ++i) {
+        for (const Fusion& f : fusions()) {
+            if (i + f.length > code.size()) continue;
+            bool match = true;
+            for (uint8_t k = 0; k < f.length && match; ++k)
+                match = base[i + k] == f.ops[k];
+            if (match) {
+                code[i].op = f.fused;
+                break;
+            }
+        }
+    }
+}
+
+const char* Bytecode::OpName(uint8_t op) {
+    static const char* names[] = {
+        "MOV", "ADD", "SUB", "MUL", "DIV", "DIV_UNCHECKED",
+        "LT", "GT", "EQ", "NE", "LE", "GE", "AND", "OR",
+        "JMP", "JNZ", "PRINT", "PRINT_NUM", "PRINT_CHAR", "PRINT_LINE",
+        "READ", "READ_NUM", "READ_CHAR", "READ_DISCARD", "SLEEP", "YIELD",
+        "ALOAD", "ASTORE", "AFILL", "ACOPY", "APRINT", "SET_TYPE", "COPY_TYPE", "HALT",
+#define SUPER_PAIR(x, y) #x "_" #y,
+#define SUPER_TRIPLE(x, y, z) #x "_" #y "_" #z,
+        SUPER_PAIRS(SUPER_PAIR)
+        SUPER_TRIPLES(SUPER_TRIPLE)
+#undef SUPER_PAIR
+#undef SUPER_TRIPLE
+    };
+    static_assert(sizeof(names) / sizeof(names[0]) == OP_COUNT, "opcode names out of date");
+    return op < OP_COUNT ? names[op] : "?";
+}
+
+void Bytecode::Print() const {
+    std::cout << "\n=== Bytecode (" << code.size() << " instructions, "
+              << slotVars.size() << " slots, " << constants.size() << " constants, "
+              << arrays.size() << " arrays of " << cells << " elements) ===" << std::endl;
+    for (uint32_t i = 0; i < code.size(); ++i)
+        PrintInstr(i);
+    std::cout << "======================\n" << std::endl;
+}
+
+void Bytecode::PrintInstr(uint32_t i) const {
+    const Instr& in = code[i];
+    std::cout << "[" << std::setw(3) << i << "] " << std::left << std::setw(22)
+              << OpName(in.op) << std::right;
+    if (in.op == OP_JMP || in.op == OP_JNZ) std::cout << " @" << in.dst;
+    else if (in.op >= OP_ASTORE && in.op <= OP_APRINT) std::cout << " A" << in.dst;
+    else std::cout << " r" << in.dst;
+    std::cout << ((in.flags & IMM_A) ? " #" : " r") << in.a;
+    std::cout << ((in.flags & IMM_B) ? " #" : " r") << in.b << std::endl;
+}
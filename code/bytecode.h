@@ -0,0 +1,107 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <map>
+#include <vector>
+#include "synt.h"
+#include "superinstructions.h"
+
+// Opcodes of the flat bytecode run by Executor
+enum Opcode : uint8_t {
+    OP_MOV,                        // dst = a
+    OP_ADD, OP_SUB, OP_MUL,        // dst = a op b
+    OP_DIV, OP_DIV_UNCHECKED,
+    OP_LT, OP_GT, OP_EQ, OP_NE, OP_LE, OP_GE, OP_AND, OP_OR,
+    OP_JMP,                        // pc = dst
+    OP_JNZ,                        // if a != 0: pc = dst
+    OP_PRINT,                      // Slot a, as its runtime type says
+    OP_PRINT_NUM, OP_PRINT_CHAR,
+    OP_PRINT_LINE,                 // "Output: a" and a newline (number literals)
+    OP_READ,                       // Into dst, as its runtime type says
+    OP_READ_NUM, OP_READ_CHAR,
+    OP_READ_DISCARD,
+    OP_SLEEP,                      // a milliseconds, after flushing output
+    OP_YIELD,
+    // Arrays are numbered in the order of Bytecode::arrays. An element's
+    // type is pad if non-zero, else the type of the value's slot.
+    OP_ALOAD,                      // dst = array a [b], with its type
+    OP_ASTORE,                     // array dst [a] = b
+    OP_AFILL,                      // Every element of array dst = a
+    OP_ACOPY,                      // Array dst = array a, as far as both reach
+    OP_APRINT,                     // Print b elements of array dst from a on
+    OP_SET_TYPE,                   // type[dst] = a
+    OP_COPY_TYPE,                  // type[dst] = type[a]
+    OP_HALT,                       // Ends every program
+    // Superinstructions run a fixed sequence of the opcodes above with one
+    // dispatch, see superinstructions.h
+#define SUPER_PAIR(x, y) OP_##x##_##y,
+#define SUPER_TRIPLE(x, y, z) OP_##x##_##y##_##z,
+    SUPER_PAIRS(SUPER_PAIR)
+    SUPER_TRIPLES(SUPER_TRIPLE)
+#undef SUPER_PAIR
+#undef SUPER_TRIPLE
+    OP_COUNT
+};
+const uint8_t OP_BASE_COUNT = OP_HALT + 1;
+
+// Operand flags
+const uint8_t IMM_A = 1;  // a is an immediate, not a slot index
+const uint8_t IMM_B = 2;
+
+// Elements of an array, in consecutive slots after the wide constants
+struct ArrayInfo {
+    uint64_t var;   // Id of the array's name
+    uint32_t base;  // Slot of element 0
+    uint32_t size;
+};
+
+// 16 bytes, four instructions per cache line. Constants that do not fit
+// in 32 bits are loaded from read-only slots, see Bytecode::constants.
+struct Instr {
+    uint8_t op;
+    uint8_t flags;
+    uint16_t pad;  // Element type of array stores and fills
+    uint32_t dst;  // Slot written or jump target
+    int32_t a;     // Slot index or immediate
+    int32_t b;
+};
+static_assert(sizeof(Instr) == 16, "Instr must stay 16 bytes");
+
+// Quads lowered to a contiguous instruction array. Variables and
+// temporaries get dense slot indices into a register file, constants
+// become immediates and labels become absolute instruction indices.
+// Runtime type tags are only maintained for the quads in tagWrites.
+// The register file holds the variables followed by the wide constants
+// and the array elements.
+class Bytecode {
+public:
+    Bytecode(const std::vector<Quad>& quads, bool tagAll, const std::vector<bool>& tagWrites);
+    ~Bytecode();
+
+    std::vector<Instr> code;
+    std::vector<uint64_t> slotVars;  // Variable id held by each slot
+    std::vector<int64_t> constants;  // Wide constants, in the slots after the variables
+    std::vector<ArrayInfo> arrays;   // Declared arrays, in the slots after the constants
+    uint32_t cells;                  // Elements of all arrays
+
+    // A superinstruction only replaces the opcode of the first instruction
+    // of its sequence, the others stay in place as its operands and for
+    // jumps into the middle of it
+    void Fuse();
+    void Print() const;
+    void PrintInstr(uint32_t i) const;
+    static const char* OpName(uint8_t op);
+private:
+    std::map<uint64_t, uint32_t> slots;  // Variable id -> slot
+    std::map<int64_t, uint32_t> pool;    // Wide constant -> index in constants
+    std::map<uint64_t, uint32_t> arrayIds;  // Array name id -> index in arrays
+
+    uint32_t slot(const SymbolInfo* var);
+    void operand(const SymbolInfo* sym, uint8_t immFlag, uint8_t& flags, int32_t& field);
+    void emit(uint8_t op, uint8_t flags, uint32_t dst, int32_t a, int32_t b);
+    void emitTyped(uint8_t op, uint8_t flags, uint32_t dst, int32_t a, int32_t b, uint16_t type);
+    static uint16_t elementType(const Quad& q);
+    void lower(const std::vector<Quad>& quads, bool tagAll, const std::vector<bool>& tagWrites);
+};
+
+#endif
@@ -0,0 +1,329 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <map>
+#include <algorithm>
+#include "cBackend.h"
+#include "symbtab.h"
+#include "ir.h"
+#include "settings.h"
+
+extern SymbTab* GLOBAL_ST;
+
+// Runtime of every generated program. cmm_read_char and cmm_read_token
+// follow Executor::readChar and Executor::readToken.
+static const char* RUNTIME = R"(#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <time.h>
+#include <sched.h>
+
+enum { CMM_NUMBER = 1, CMM_CHAR = 2 };
+
+static int64_t cmm_read_char(void) {
+    int c;
+    do c = getchar(); while (c != EOF && isspace(c));
+    return c == EOF ? 0 : (int64_t)(char)c;
+}
+
+static int cmm_token(char* buf, size_t size) {
+    int c;
+    size_t n = 0;
+    do c = getchar(); while (c != EOF && isspace(c));
+    if (c == EOF) return 0;
+    while (c != EOF && !isspace(c)) {
+        if (n + 1 < size) buf[n++] = (char)c;
+        c = getchar();
+    }
+    if (c != EOF) ungetc(c, stdin);
+    buf[n] = 0;
+    return 1;
+}
+
+static int64_t cmm_read_token(uint8_t* type) {
+    char token[256];
+    char* end;
+    long long v;
+    size_t len;
+    if (!cmm_token(token, sizeof(token))) {
+        *type = CMM_NUMBER;
+        return 0;
+    }
+    len = strlen(token);
+    if (len >= 3 && token[0] == '\'' && token[len - 1] == '\'') {
+        *type = CMM_CHAR;
+        return (int64_t)token[1];
+    }
+    errno = 0;
+    v = strtoll(token, &end, 10);
+    if (end != token && errno != ERANGE) {
+        *type = CMM_NUMBER;
+        return (int64_t)v;
+    }
+    *type = CMM_CHAR;
+    return (int64_t)token[0];
+}
+
+static void cmm_discard(void) {
+    char token[256];
+    cmm_token(token, sizeof(token));
+}
+
+static void cmm_print_number(int64_t v) {
+#if CMM_PRINT_NEWLINE
+    printf("Output: %lld\n", (long long)v);
+#else
+    printf("%lld", (long long)v);
+#endif
+}
+
+static void cmm_print_char(int64_t v) {
+#if CMM_PRINT_NEWLINE
+    printf("Output: %c\n", (char)v);
+#else
+    putchar((unsigned char)(char)v);
+#endif
+}
+
+static void cmm_fill(int64_t* values, uint8_t* types, uint32_t n, int64_t v, uint8_t type) {
+    uint32_t i;
+    for (i = 0; i < n; ++i) values[i] = v;
+    memset(types, type, n);
+}
+
+static int cmm_print_range(const int64_t* values, const uint8_t* types, uint32_t n,
+                           int64_t from, int64_t count) {
+    int64_t i;
+    if ((uint64_t)from > n || (uint64_t)count > n - (uint64_t)from) {
+        printf("ERROR: Array index out of range!\n");
+        return 0;
+    }
+    for (i = from; i < from + count; ++i) {
+        if (types[i] == CMM_CHAR) cmm_print_char(values[i]);
+        else cmm_print_number(values[i]);
+    }
+    return 1;
+}
+
+static void cmm_sleep(int64_t ms) {
+    struct timespec ts;
+    fflush(stdout);
+    if (ms <= 0) return;
+    ts.tv_sec = (time_t)(ms / 1000);
+    ts.tv_nsec = (long)(ms % 1000) * 1000000L;
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {}
+}
+
+)";
+
+CBackend::CBackend(const std::vector<Quad>& quads, const std::set<uint64_t>* taggedVars)
+        : quads(quads), taggedVars(taggedVars) {
+    // Constructor
+    for (const Quad& q : quads)
+        if (isArrayQuad(q) && q.op->val == SymbolInfo::DECLARE)
+            arraySizes[q.res->val] = static_cast<uint32_t>(q.arg1->val);
+}
+
+CBackend::~CBackend() {
+    // Destructor
+}
+
+bool CBackend::tagged(const SymbolInfo* sym) const {
+    return taggedVars == nullptr || taggedVars->count(sym->val) > 0;
+}
+
+std::string CBackend::var(const SymbolInfo* sym) const {
+    if (isTempSym(sym)) return "t" + std::to_string(sym->val - TEMP_BASE);
+    return "v" + std::to_string(sym->val);
+}
+
+std::string CBackend::type(const SymbolInfo* sym) const {
+    return var(sym) + "_type";
+}
+
+std::string CBackend::array(uint64_t id) const {
+    return "a" + std::to_string(id);
+}
+
+std::string CBackend::arrayStatement(const Quad& q) const {
+    const SymbolInfo* arr = q.op->val == SymbolInfo::LOAD ? q.arg1 : q.res;
+    std::string a = array(arr->val), t = a + "_type";
+    std::string size = std::to_string(arraySizes.at(arr->val));
+    std::string check = "if ((uint64_t)" + value(q.arg2) + " >= " + size +
+                        ") { printf(\"ERROR: Array index out of range!\\n\"); return 0; } ";
+    std::string elementType = "CMM_NUMBER";
+    if (q.op->val == SymbolInfo::STORE_CHAR || q.op->val == SymbolInfo::FILL_CHAR ||
+        (q.arg1 != nullptr && q.arg1->code == SymbolInfo::CHAR))
+        elementType = "CMM_CHAR";
+    else if (isVarSym(q.arg1) && q.op->val != SymbolInfo::STORE_NUMBER && q.op->val != SymbolInfo::FILL_NUMBER)
+        elementType = type(q.arg1);
+
+    switch (q.op->val) {
+        case SymbolInfo::DECLARE:
+            return "memset(" + a + ", 0, sizeof(" + a + ")); memset(" + t + ", CMM_NUMBER, sizeof(" + t + "));";
+        case SymbolInfo::LOAD: {
+            std::string s = check + var(q.res) + " = " + a + "[" + value(q.arg2) + "];";
+            if (tagged(q.res)) s += " " + type(q.res) + " = " + t + "[" + value(q.arg2) + "];";
+            return s;
+        }
+        case SymbolInfo::FILL: case SymbolInfo::FILL_NUMBER: case SymbolInfo::FILL_CHAR:
+            return "cmm_fill(" + a + ", " + t + ", " + size + ", " + value(q.arg1) + ", " + elementType + ");";
+        case SymbolInfo::COPY: {
+            std::string n = std::to_string(std::min(arraySizes.at(q.res->val), arraySizes.at(q.arg1->val)));
+            return "memmove(" + a + ", " + array(q.arg1->val) + ", " + n + " * sizeof(int64_t)); memmove(" +
+                   t + ", " + array(q.arg1->val) + "_type, " + n + ");";
+        }
+        case SymbolInfo::PRINT_RANGE:
+            return "if (!cmm_print_range(" + a + ", " + t + ", " + size + ", " + value(q.arg1) + ", " +
+                   value(q.arg2) + ")) return 0;";
+        default:
+            return check + a + "[" + value(q.arg2) + "] = " + value(q.arg1) + "; " +
+                   t + "[" + value(q.arg2) + "] = " + elementType + ";";
+    }
+}
+
+// Constants outside int32 go through uint64_t so INT64_MIN needs no
+// special spelling
+std::string CBackend::value(const SymbolInfo* sym) const {
+    if (isVarSym(sym)) return var(sym);
+    int64_t v = isConstSym(sym) ? static_cast<int64_t>(sym->val) : 0;
+    if (v >= INT32_MIN && v <= INT32_MAX) return std::to_string(v);
+    return "(int64_t)" + std::to_string(static_cast<uint64_t>(v)) + "ULL";
+}
+
+std::string CBackend::statement(const Quad& q, const std::set<uint64_t>& labels) const {
+    if (q.op == nullptr) {
+        if (isLabelSym(q.res) && labels.count(q.res->val) > 0)
+            return "L" + std::to_string(q.res->val - LABEL_BASE) + ":;";
+        return "";
+    }
+    if (isGotoQuad(q)) {
+        // The interpreter falls through jumps to missing labels
+        if (q.res == nullptr || labels.count(q.res->val) == 0) return "";
+        std::string jump = "goto L" + std::to_string(q.res->val - LABEL_BASE) + ";";
+        if (q.arg1 == nullptr) return jump;
+        if (!isVarSym(q.arg1)) return q.arg1->val != 0 ? jump : "";
+        return "if (" + var(q.arg1) + ") " + jump;
+    }
+    if (isAssignQuad(q)) {
+        std::string s = var(q.res) + " = " + value(q.arg1) + ";";
+        if (!tagged(q.res)) return s;
+        if (isVarSym(q.arg1)) return s + " " + type(q.res) + " = " + type(q.arg1) + ";";
+        return s + " " + type(q.res) + " = " +
+               (q.arg1->code == SymbolInfo::CHAR ? "CMM_CHAR;" : "CMM_NUMBER;");
+    }
+    if (isBinaryQuad(q)) {
+        std::string a = value(q.arg1), b = value(q.arg2), expr;
+        if (q.op->code == SymbolInfo::OPERATOR) {
+            switch (q.op->val) {
+                case SymbolInfo::PLUS: expr = a + " + " + b; break;
+                case SymbolInfo::MINUS: expr = a + " - " + b; break;
+                case SymbolInfo::MULTI: expr = a + " * " + b; break;
+                case SymbolInfo::SLASH: case SymbolInfo::SLASH_UNCHECKED: expr = a + " / " + b; break;
+                case SymbolInfo::LESS: expr = a + " < " + b; break;
+                default: expr = a + " > " + b; break;
+            }
+        }
+        else {
+            switch (q.op->val) {
+                case SymbolInfo::LOGICAL_EQUALS: expr = a + " == " + b; break;
+                case SymbolInfo::NOT_EQUALS: expr = a + " != " + b; break;
+                case SymbolInfo::LESS_EQUAL: expr = a + " <= " + b; break;
+                case SymbolInfo::MORE_EQUAL: expr = a + " >= " + b; break;
+                case SymbolInfo::AND: expr = a + " && " + b; break;
+                default: expr = a + " || " + b; break;
+            }
+        }
+        std::string s;
+        if (isOp(q, SymbolInfo::OPERATOR, SymbolInfo::SLASH))
+            s = "if (" + b + " == 0) { printf(\"ERROR: Division by zero!\\n\"); return 0; } ";
+        s += var(q.res) + " = " + expr + ";";
+        if (tagged(q.res)) s += " " + type(q.res) + " = CMM_NUMBER;";
+        return s;
+    }
+    if (isPrintQuad(q)) {
+        if (q.arg1 == nullptr) return "";
+        std::string a = value(q.arg1);
+        if (q.op->val == SymbolInfo::PRINT_NUMBER) return "cmm_print_number(" + a + ");";
+        if (q.op->val == SymbolInfo::PRINT_CHAR || q.arg1->code == SymbolInfo::CHAR)
+            return "cmm_print_char(" + a + ");";
+        if (q.arg1->code == SymbolInfo::NUMBER) return "printf(\"Output: %lld\\n\", (long long)" + a + ");";
+        return "if (" + type(q.arg1) + " == CMM_CHAR) cmm_print_char(" + a + "); else cmm_print_number(" + a + ");";
+    }
+    if (isReadQuad(q)) {
+        if (!isVarSym(q.res)) return "cmm_discard();";
+        std::string s = "printf(\"Input: \"); ";
+        std::string t = type(q.res);
+        if (q.op->val == SymbolInfo::READ_CHAR)
+            return s + var(q.res) + " = cmm_read_char(); " + t + " = CMM_CHAR;";
+        if (q.op->val == SymbolInfo::READ_NUMBER)
+            return s + var(q.res) + " = cmm_read_token(&" + t + ");";
+        return s + "if (" + t + " == CMM_CHAR) " + var(q.res) + " = cmm_read_char(); else " +
+               var(q.res) + " = cmm_read_token(&" + t + ");";
+    }
+    if (isOp(q, SymbolInfo::CONSOLE, SymbolInfo::SLEEP)) return "cmm_sleep(" + value(q.arg1) + ");";
+    if (isOp(q, SymbolInfo::CONSOLE, SymbolInfo::YIELD)) return "sched_yield();";
+    if (isArrayQuad(q)) return arrayStatement(q);
+    return "";
+}
+
+std::string CBackend::Source() {
+    // Variables in order of first appearance, and the labels jumps reach
+    std::map<uint64_t, const SymbolInfo*> vars;
+    std::set<uint64_t> labels, targets;
+    for (const Quad& q : quads) {
+        for (const SymbolInfo* s : {q.arg1, q.arg2, q.res})
+            if (isVarSym(s)) vars.insert({s->val, s});
+        if (q.op == nullptr && isLabelSym(q.res)) labels.insert(q.res->val);
+    }
+    for (const Quad& q : quads)
+        if (isGotoQuad(q) && q.res != nullptr && labels.count(q.res->val) > 0)
+            targets.insert(q.res->val);
+
+    std::ostringstream out;
+    out << "/* Generated from " << INPUT_FILE << " */\n"
+        << "#define CMM_PRINT_NEWLINE " << (PRINT_NEWLINE ? 1 : 0) << "\n" << RUNTIME;
+    // Static, so large arrays stay off the stack
+    for (const auto& a : arraySizes) {
+        out << "static int64_t " << array(a.first) << "[" << a.second << "]; static uint8_t "
+            << array(a.first) << "_type[" << a.second << "];";
+        if (GLOBAL_ST != nullptr) {
+            std::string name = GLOBAL_ST->getName(SymbolInfo::VARIABLE, a.first);
+            if (!name.empty()) out << " /* " << name << " */";
+        }
+        out << "\n";
+    }
+    out << "\nint main(void) {\n";
+    for (const auto& v : vars) {
+        out << "    int64_t " << var(v.second) << " = 0; uint8_t " << type(v.second) << " = CMM_NUMBER;";
+        if (!isTempSym(v.second) && GLOBAL_ST != nullptr) {
+            std::string name = GLOBAL_ST->getName(SymbolInfo::VARIABLE, v.first);
+            if (!name.empty()) out << " /* " << name << " */";
+        }
+        out << "\n";
+    }
+    for (const auto& a : arraySizes)
+        out << "    memset(" << array(a.first) << "_type, CMM_NUMBER, " << a.second << ");\n";
+    for (const Quad& q : quads) {
+        std::string s = statement(q, targets);
+        if (!s.empty()) out << "    " << s << "\n";
+    }
+    out << "    return 0;\n}\n";
+    return out.str();
+}
+
+bool CBackend::Write(const std::string& path) {
+    std::ofstream out(path);
+    if (!out) return false;
+    out << Source();
+    return static_cast<bool>(out);
+}
+
+bool CBackend::Compile(const std::string& cPath, const std::string& binPath) {
+    std::string command = C_COMPILER + " -o " + binPath + " " + cPath;
+    return std::system(command.c_str()) == 0;
+}
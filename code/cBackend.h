@@ -0,0 +1,38 @@
+#ifndef CBACKEND_H
+#define CBACKEND_H
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include "synt.h"
+
+// Translates the quads into a self-contained C program: variables become
+// locals, arrays static arrays with a type array beside them, labels C
+// labels and GOTO goto. Print and read go through small helpers in the
+// generated file that reproduce the executor's formats.
+class CBackend {
+public:
+    // taggedVars as given by the optimizer, nullptr to tag every variable
+    CBackend(const std::vector<Quad>& quads, const std::set<uint64_t>* taggedVars);
+    ~CBackend();
+
+    std::string Source();
+    bool Write(const std::string& path);
+    // Runs C_COMPILER on a generated file, false if it failed
+    static bool Compile(const std::string& cPath, const std::string& binPath);
+private:
+    const std::vector<Quad>& quads;
+    const std::set<uint64_t>* taggedVars;
+    std::map<uint64_t, uint32_t> arraySizes;  // Array name id -> elements
+
+    bool tagged(const SymbolInfo* var) const;
+    std::string value(const SymbolInfo* sym) const;
+    std::string var(const SymbolInfo* sym) const;
+    std::string type(const SymbolInfo* sym) const;
+    std::string array(uint64_t id) const;
+    std::string arrayStatement(const Quad& q) const;
+    std::string statement(const Quad& q, const std::set<uint64_t>& labels) const;
+};
+
+#endif
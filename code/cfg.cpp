@@ -0,0 +1,134 @@
+#include "cfg.h"
+#include "ir.h"
+
+CFG::CFG(const std::vector<Quad>& quads) : quads(quads) {
+    buildBlocks();
+    computeDominators();
+}
+
+CFG::~CFG() {
+    // Destructor
+}
+
+uint32_t CFG::BlockOf(uint32_t quadIdx) const {
+    return blockOfQuad[quadIdx];
+}
+
+uint32_t CFG::LabelBlock(uint64_t label) const {
+    auto it = labelBlock.find(label);
+    return it != labelBlock.end() ? it->second : UINT32_MAX;
+}
+
+bool CFG::Dominates(uint32_t a, uint32_t b) const {
+    if (!Reachable(a) || !Reachable(b)) return false;
+    while (b != a && b != 0)
+        b = idom[b];
+    return b == a;
+}
+
+// Leaders are the first quad, every label and every quad following a goto
+void CFG::buildBlocks() {
+    uint32_t n = quads.size();
+    blockOfQuad.assign(n, 0);
+    if (n == 0) return;
+
+    std::vector<bool> leader(n, false);
+    leader[0] = true;
+    for (uint32_t i = 0; i < n; ++i) {
+        if (isLabelQuad(quads[i])) leader[i] = true;
+        if (isGotoQuad(quads[i]) && i + 1 < n) leader[i + 1] = true;
+    }
+
+    for (uint32_t i = 0; i < n; ++i) {
+        if (leader[i]) {
+            BasicBlock bb;
+            bb.first = i;
+            bb.last = i;
+            blocks.push_back(bb);
+        }
+        blocks.back().last = i + 1;
+        blockOfQuad[i] = blocks.size() - 1;
+        if (isLabelQuad(quads[i]))
+            labelBlock[quads[i].res->val] = blocks.size() - 1;
+    }
+
+    for (uint32_t b = 0; b < blocks.size(); ++b) {
+        const Quad& tail = quads[blocks[b].last - 1];
+        bool fallsThrough = true;
+        if (isGotoQuad(tail)) {
+            uint32_t target = LabelBlock(tail.res != nullptr ? tail.res->val : 0);
+            if (target != UINT32_MAX) {
+                blocks[b].succs.push_back(target);
+                // A goto to a missing label falls through in the executor
+                fallsThrough = tail.arg1 != nullptr;
+            }
+        }
+        if (fallsThrough && b + 1 < blocks.size() &&
+                (blocks[b].succs.empty() || blocks[b].succs[0] != b + 1))
+            blocks[b].succs.push_back(b + 1);
+        for (uint32_t s : blocks[b].succs)
+            blocks[s].preds.push_back(b);
+    }
+}
+
+// Cooper, Harvey and Kennedy's iterative dominator algorithm
+void CFG::computeDominators() {
+    uint32_t n = blocks.size();
+    idom.assign(n, UINT32_MAX);
+    domChildren.assign(n, std::vector<uint32_t>());
+    if (n == 0) return;
+
+    // Iterative DFS for the postorder
+    std::vector<uint32_t> postorder;
+    std::vector<uint32_t> poNum(n, UINT32_MAX);
+    std::vector<bool> visited(n, false);
+    std::vector<std::pair<uint32_t, uint32_t>> stack;  // block, next successor
+    stack.push_back({0, 0});
+    visited[0] = true;
+    while (!stack.empty()) {
+        auto& top = stack.back();
+        if (top.second < blocks[top.first].succs.size()) {
+            uint32_t s = blocks[top.first].succs[top.second++];
+            if (!visited[s]) {
+                visited[s] = true;
+                stack.push_back({s, 0});
+            }
+        }
+        else {
+            poNum[top.first] = postorder.size();
+            postorder.push_back(top.first);
+            stack.pop_back();
+        }
+    }
+    rpo.assign(postorder.rbegin(), postorder.rend());
+
+    idom[0] = 0;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (uint32_t b : rpo) {
+            if (b == 0) continue;
+            uint32_t newIdom = UINT32_MAX;
+            for (uint32_t p : blocks[b].preds) {
+                if (idom[p] == UINT32_MAX) continue;
+                if (newIdom == UINT32_MAX) {
+                    newIdom = p;
+                    continue;
+                }
+                uint32_t x = p, y = newIdom;
+                while (x != y) {
+                    while (poNum[x] < poNum[y]) x = idom[x];
+                    while (poNum[y] < poNum[x]) y = idom[y];
+                }
+                newIdom = x;
+            }
+            if (newIdom != idom[b]) {
+                idom[b] = newIdom;
+                changed = true;
+            }
+        }
+    }
+
+    for (uint32_t b : rpo)
+        if (b != 0) domChildren[idom[b]].push_back(b);
+}
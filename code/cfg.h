@@ -0,0 +1,40 @@
+#ifndef CFG_H
+#define CFG_H
+
+#include <map>
+#include <vector>
+#include "synt.h"
+
+struct BasicBlock {
+    uint32_t first;  // Index of the first quad in the block
+    uint32_t last;   // Index one past the last quad in the block
+    std::vector<uint32_t> succs;
+    std::vector<uint32_t> preds;
+};
+
+// Control flow graph and dominator tree over a quad vector.
+// It is a snapshot: rebuild it after passes that move or delete quads.
+class CFG {
+public:
+    CFG(const std::vector<Quad>& quads);
+    ~CFG();
+
+    std::vector<BasicBlock> blocks;
+    std::vector<uint32_t> idom;                   // Immediate dominator (UINT32_MAX if unreachable)
+    std::vector<std::vector<uint32_t>> domChildren;
+    std::vector<uint32_t> rpo;                    // Reachable blocks in reverse postorder
+
+    uint32_t BlockOf(uint32_t quadIdx) const;
+    uint32_t LabelBlock(uint64_t label) const;    // Block starting at a label (UINT32_MAX if missing)
+    bool Dominates(uint32_t a, uint32_t b) const;
+    bool Reachable(uint32_t b) const { return idom[b] != UINT32_MAX; }
+private:
+    const std::vector<Quad>& quads;
+    std::vector<uint32_t> blockOfQuad;
+    std::map<uint64_t, uint32_t> labelBlock;
+
+    void buildBlocks();
+    void computeDominators();
+};
+
+#endif
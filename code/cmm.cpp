@@ -0,0 +1,79 @@
+#include <sstream>
+#include "cmm.h"
+#include "lex.h"
+#include "synt.h"
+#include "optimizer.h"
+#include "passManager.h"
+#include "executor.h"
+
+CmmProgram::CmmProgram() {
+    lex = nullptr;
+    synt = nullptr;
+    optimizer = nullptr;
+    bytecode = nullptr;
+}
+
+CmmProgram::~CmmProgram() {
+    delete bytecode;
+    delete optimizer;
+    delete synt;
+    delete lex;
+}
+
+// The same steps as main, with the messages collected instead of printed.
+// The bytecode is lowered here so runs only set up their registers.
+bool CmmProgram::Compile(const std::string& source, uint8_t optLevel) {
+    if (lex != nullptr) {
+        errors = "already compiled\n";
+        return false;
+    }
+    std::ostringstream messages;
+    lex = new Lex("<source>", &source);
+    lex->messages = &messages;
+    SymbolInfo* si = lex->LexAnalyze();
+    while (si != nullptr) {
+        lex->symbolList.push_back(*si);
+        lex->lines.push_back(lex->currLine);
+        si = lex->LexAnalyze();
+    }
+    if (lex->error) {
+        errors = messages.str();
+        return false;
+    }
+
+    synt = new Synt(lex->symbolList, lex->lines);
+    synt->messages = &messages;
+    if (!synt->Parse()) {
+        errors = messages.str();
+        return false;
+    }
+
+    if (optLevel > 0) {
+        optimizer = new Optimizer(synt->quads, synt->whileLoops);
+        PassManager* passManager = new PassManager(synt->quads);
+        optimizer->AddPasses(*passManager, optLevel);
+        bool verified = passManager->Run();
+        delete passManager;
+        if (!verified) {
+            errors = "the optimized program did not verify\n";
+            return false;
+        }
+    }
+
+    Executor* lowering = new Executor(synt->quads);
+    if (optimizer != nullptr)
+        lowering->SetTaggedVars(optimizer->TaggedVars());
+    bytecode = lowering->Lower();
+    delete lowering;
+    return true;
+}
+
+void CmmProgram::Run(const CmmIO& io) const {
+    if (bytecode == nullptr) return;
+    Output::Sink write = io.write;
+    if (!write) write = [](const char*, size_t) {};
+    Executor* executor = new Executor(synt->quads);
+    executor->SetIO(io.read, write);
+    executor->Execute(*bytecode);
+    delete executor;
+}
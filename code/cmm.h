@@ -0,0 +1,48 @@
+#ifndef CMM_H
+#define CMM_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include "settings.h"
+
+class Lex;
+class Synt;
+class Optimizer;
+class Bytecode;
+
+// Input and output of one run. read fills up to n bytes of data and
+// returns how many, 0 at the end of input; write takes each flushed piece
+// of output. An empty read is no input, an empty write drops the output.
+struct CmmIO {
+    std::function<size_t(char* data, size_t n)> read;
+    std::function<void(const char* data, size_t n)> write;
+};
+
+// Embedding API, built into libcmm.a by "make libcmm". A program is
+// compiled from source text once and is immutable afterwards, so any
+// number of threads can run it at the same time. Each run has its own
+// registers, input and output and touches no process-wide state: no
+// files, std::cin, std::cout or GLOBAL_ST. Runs are interpreted, reads
+// are unprompted like with -batch.
+class CmmProgram {
+public:
+    CmmProgram();
+    ~CmmProgram();
+
+    // False if source does not compile, Errors says why. Call it once.
+    bool Compile(const std::string& source, uint8_t optLevel = OPT_LEVEL);
+    const std::string& Errors() const { return errors; }
+    bool Compiled() const { return bytecode != nullptr; }
+    void Run(const CmmIO& io) const;  // Does nothing unless compiled
+private:
+    // The quads point into the symbols of lex and synt, so they live as
+    // long as the program
+    Lex* lex;
+    Synt* synt;
+    Optimizer* optimizer;
+    Bytecode* bytecode;
+    std::string errors;
+};
+
+#endif
@@ -0,0 +1,123 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include "execPolicy.h"
+
+CountingPolicy::CountingPolicy(PairProfile* pairs) : pairs(pairs) {
+    opCounts.assign(OP_COUNT, 0);
+}
+
+void CountingPolicy::Print() {
+    uint64_t total = 0;
+    for (uint64_t count : opCounts) total += count;
+    std::cout << "=== Instruction Counts (" << total << " dispatches) ===" << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    for (uint8_t op = 0; op < OP_COUNT; ++op) {
+        if (opCounts[op] == 0) continue;
+        std::cout << std::left << std::setw(24) << Bytecode::OpName(op) << std::right << std::setw(14)
+                  << opCounts[op] << std::setw(7) << 100.0 * opCounts[op] / total << "%" << std::endl;
+    }
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout << "=======================" << std::endl << std::endl;
+}
+
+TracePolicy::TracePolicy(const Bytecode& bc) : bc(bc) {
+    // Constructor
+}
+
+StepPolicy::StepPolicy(const Bytecode& bc, std::function<void()> printVars)
+        : bc(bc), printVars(printVars) {
+    running = false;
+}
+
+// Commands: Enter or s steps, c continues to the next breakpoint,
+// b N / d N set and delete a breakpoint at instruction N, v prints the
+// variables, l lists the bytecode and q stops the program
+bool StepPolicy::prompt(uint32_t pc) {
+    running = false;
+    bc.PrintInstr(pc);
+    for (;;) {
+        std::cout << "(step) ";
+        std::string line;
+        if (!std::getline(std::cin, line)) return true;
+        std::istringstream words(line);
+        std::string cmd;
+        words >> cmd;
+        if (cmd.empty() || cmd == "s") return true;
+        if (cmd == "c") {
+            running = true;
+            return true;
+        }
+        if (cmd == "q") return false;
+        if (cmd == "v") printVars();
+        else if (cmd == "l") bc.Print();
+        else if (cmd == "b" || cmd == "d") {
+            uint32_t target;
+            if (!(words >> target) || target >= bc.code.size()) {
+                std::cout << "No instruction with that number" << std::endl;
+                continue;
+            }
+            if (cmd == "b") breakpoints.insert(target);
+            else breakpoints.erase(target);
+        }
+        else std::cout << "Commands: s, c, b N, d N, v, l, q" << std::endl;
+    }
+}
+
+TieringPolicy::TieringPolicy(const Bytecode& bc, const Bytecode& plain) : bc(bc), plain(plain) {
+    headers.assign(bc.code.size(), false);
+    counts.assign(bc.code.size(), 0);
+    for (uint32_t i = 0; i < plain.code.size(); ++i) {
+        const Instr& in = plain.code[i];
+        if ((in.op == OP_JMP || in.op == OP_JNZ) && in.dst <= i) headers[in.dst] = true;
+    }
+    jit = nullptr;
+    ready = false;
+    osrPc = UINT32_MAX;
+}
+
+TieringPolicy::~TieringPolicy() {
+    if (compiler.joinable()) compiler.join();
+    delete jit;
+}
+
+void TieringPolicy::compile(uint32_t hotPc) {
+    if(DEBUG)
+        std::cout << "(loop at " << hotPc << " is hot, compiling)" << std::endl;
+    jit = new Jit(plain);
+    compiler = std::thread([this]() {
+        if (jit->Compile()) ready.store(true, std::memory_order_release);
+    });
+}
+
+SlicePolicy::SlicePolicy(const Bytecode& bc) : bc(bc) {
+    stops.assign(bc.code.size(), STOP_NONE);
+    for (uint32_t i = 0; i < bc.code.size(); ++i) {
+        const Instr& in = bc.code[i];
+        if ((in.op == OP_JMP || in.op == OP_JNZ) && in.dst <= i && stops[in.dst] == STOP_NONE)
+            stops[in.dst] = STOP_HEADER;
+    }
+    for (uint32_t i = 0; i < bc.code.size(); ++i) {
+        uint8_t op = bc.code[i].op;
+        if (op >= OP_READ && op <= OP_READ_DISCARD) stops[i] = STOP_READ;
+        else if (op == OP_SLEEP) stops[i] = STOP_SLEEP;
+        else if (op == OP_YIELD) stops[i] = STOP_YIELD;
+    }
+    budget = 0;
+    resuming = false;
+    stop = STOP_NONE;
+    stopPc = 0;
+    code = bc.code.data();
+    at = stops.data();
+}
+
+bool SlicePolicy::boundary(uint32_t pc) {
+    if (resuming) {
+        resuming = false;
+        return true;
+    }
+    if (stops[pc] == STOP_HEADER && budget > 0) return true;
+    stop = stops[pc];
+    stopPc = pc;
+    return false;
+}
@@ -0,0 +1,143 @@
+#ifndef EXECPOLICY_H
+#define EXECPOLICY_H
+
+#include <atomic>
+#include <functional>
+#include <set>
+#include <thread>
+#include <vector>
+#include "bytecode.h"
+#include "pairProfile.h"
+#include "jit.h"
+#include "settings.h"
+
+// What the VM does before dispatching each instruction. Executor::run is
+// compiled once per policy, so the fast loop carries no checks for the
+// others. Dispatch returns false to stop the program; it is only called
+// for policies with ACTIVE set, so even unoptimized builds leave the fast
+// loop alone.
+
+// Runs the program and nothing else
+struct FastPolicy {
+    static const bool ACTIVE = false;
+    bool Dispatch(const Instr*) { return true; }
+};
+
+// Counts executed instructions per opcode and feeds the pair profile
+struct CountingPolicy {
+    static const bool ACTIVE = true;
+    CountingPolicy(PairProfile* pairs);
+
+    std::vector<uint64_t> opCounts;  // Dispatches per opcode
+    PairProfile* pairs;              // Not owned, may be nullptr
+
+    bool Dispatch(const Instr* in) {
+        ++opCounts[in->op];
+        if (pairs != nullptr) pairs->Record(in);
+        return true;
+    }
+    void Print();
+};
+
+// Prints every instruction before it runs
+struct TracePolicy {
+    static const bool ACTIVE = true;
+    TracePolicy(const Bytecode& bc);
+
+    const Bytecode& bc;
+
+    bool Dispatch(const Instr* in) {
+        bc.PrintInstr(static_cast<uint32_t>(in - bc.code.data()));
+        return true;
+    }
+};
+
+// Stops before every instruction, or only at breakpoints after "c", and
+// reads debugger commands from standard input
+struct StepPolicy {
+    static const bool ACTIVE = true;
+    StepPolicy(const Bytecode& bc, std::function<void()> printVars);
+
+    const Bytecode& bc;
+    std::function<void()> printVars;  // Current values of the variables
+    std::set<uint32_t> breakpoints;   // Instruction indices
+    bool running;                     // Continue to the next breakpoint
+
+    bool Dispatch(const Instr* in) {
+        uint32_t pc = static_cast<uint32_t>(in - bc.code.data());
+        if (running && breakpoints.count(pc) == 0) return true;
+        return prompt(pc);
+    }
+private:
+    bool prompt(uint32_t pc);
+};
+
+// Interprets while counting the iterations of every loop. Once a loop
+// header has run TIER_HOT_LOOP times the program is compiled by the JIT on
+// a background thread, and the next time any loop header is reached the
+// interpreter stops so Executor can continue in machine code from there.
+// Both tiers share the register file, so no state has to be moved.
+struct TieringPolicy {
+    static const bool ACTIVE = true;
+    // bc is what the interpreter runs, plain the same code without
+    // superinstructions for the JIT
+    TieringPolicy(const Bytecode& bc, const Bytecode& plain);
+    ~TieringPolicy();
+
+    const Bytecode& bc;
+    const Bytecode& plain;
+    std::vector<bool> headers;     // Per instruction: a backward jump targets it
+    std::vector<uint32_t> counts;  // Times each header was reached
+    Jit* jit;                      // Owned, filled in by the compile thread
+    std::thread compiler;
+    std::atomic<bool> ready;       // jit compiled successfully
+    uint32_t osrPc;                // Header to enter the machine code at, UINT32_MAX if none
+
+    bool Dispatch(const Instr* in) {
+        uint32_t pc = static_cast<uint32_t>(in - bc.code.data());
+        if (!headers[pc]) return true;
+        if (ready.load(std::memory_order_acquire)) {
+            osrPc = pc;
+            return false;
+        }
+        if (++counts[pc] == TIER_HOT_LOOP && jit == nullptr) compile(pc);
+        return true;
+    }
+private:
+    void compile(uint32_t hotPc);
+};
+
+// Runs one time slice of a green thread, see Scheduler. The slice ends
+// at the first loop header once budget dispatches have run, so a thread
+// keeps its place in a loop, and before every read(), sleep() and yield(),
+// which the scheduler handles itself. Executor::Slice continues from
+// stopPc.
+struct SlicePolicy {
+    static const bool ACTIVE = true;
+    // Why a slice ended. STOP_NONE: the program did.
+    enum Stop : uint8_t { STOP_NONE, STOP_HEADER, STOP_READ, STOP_SLEEP, STOP_YIELD };
+
+    SlicePolicy(const Bytecode& bc);
+
+    const Bytecode& bc;
+    std::vector<uint8_t> stops;  // Per instruction: Stop a slice can end before it with
+    int64_t budget;              // Dispatches left before the next loop header ends the slice
+    bool resuming;               // Run the instruction the last slice ended before
+    uint8_t stop;
+    uint32_t stopPc;
+
+    // Most instructions cannot end a slice, they only cost a lookup
+    bool Dispatch(const Instr* in) {
+        uint32_t pc = static_cast<uint32_t>(in - code);
+        --budget;
+        if (at[pc] == STOP_NONE) return true;
+        return boundary(pc);
+    }
+private:
+    const Instr* code;
+    const uint8_t* at;  // stops, without a call per dispatch in unoptimized builds
+
+    bool boundary(uint32_t pc);
+};
+
+#endif
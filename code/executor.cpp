@@ -1,9 +1,18 @@
 #include <iostream>
 #include <iomanip>
+#include <algorithm>
 #include <cstdint>
 #include <functional>
 #include <string>
+#include <thread>
+#include <chrono>
 #include "executor.h"
+#include "ir.h"
+#include "execPolicy.h"
+#include "jit.h"
+#include "arrayOps.h"
+#include "output.h"
+#include "input.h"
 #include "symbtab.h"
 #include "symbInfo.h"
 #include "settings.h"
@@ -13,17 +22,40 @@
 SymbTab* GLOBAL_ST = nullptr;
 
 Executor::Executor(std::vector<Quad>& quads) : quads(quads) {
-    buildLabelMap();
+    tagAll = true;
+    threadedDispatch = true;
+    superinstructions = SUPERINSTRUCTIONS;
+    profile = nullptr;
+    useJit = false;
+    tiered = false;
+    flushPolicy = OUTPUT_FLUSH;
+    out = nullptr;
+    batchInput = false;
+    input = nullptr;
+    customIO = false;
+    mode = RUNTIME_DEBUGGING ? EXEC_STEPPING : EXEC_FAST;
+    sliced = nullptr;
+    sliceState = nullptr;
+    slicer = nullptr;
 }
 
 Executor::~Executor() {
     // Destructor
+    delete slicer;
+    delete sliceState;
+    delete sliced;
+}
+
+// sleep(ms), a blocking wait that leaves the processor to others.
+// Zero or negative durations return at once.
+static void sleepFor(int64_t ms) {
+    if (ms > 0) std::this_thread::sleep_for(std::chrono::milliseconds(ms));
 }
 
 // Helper to format a SymbolInfo as a readable name
 static std::string formatSymbol(SymbolInfo* s, SymbTab* symbtab, const std::function<bool(SymbolInfo*)>& isLabelFn) {
     if (!s) return "_";
-    if (s->code == SymbolInfo::NUMBER) return std::to_string(s->val);
+    if (s->code == SymbolInfo::NUMBER) return std::to_string(static_cast<int64_t>(s->val));
     if (s->code == SymbolInfo::CHAR) {
         std::string out = "'";
         out.push_back(static_cast<char>(s->val));
@@ -41,6 +73,11 @@ static std::string formatSymbol(SymbolInfo* s, SymbTab* symbtab, const std::func
         // fallback to numeric id
         return "v" + std::to_string(s->val);
     }
+    if (s->code == SymbolInfo::ARRAY) {
+        // Arrays are named by the variable id of their name
+        std::string name = symbtab ? symbtab->getName(SymbolInfo::VARIABLE, s->val) : "";
+        return name.empty() ? "a" + std::to_string(s->val) : name + "[]";
+    }
     return "_";
 }
 
@@ -96,6 +133,54 @@ void Executor::setValue(SymbolInfo* sym, int64_t value) {
     }
 }
 
+// Without this every assignment records its value's type, which print and
+// read need for variables whose type the optimizer could not determine
+void Executor::SetTaggedVars(const std::set<uint64_t>& vars) {
+    tagAll = false;
+    tagWrites.assign(quads.size(), false);
+    for (uint32_t i = 0; i < quads.size(); ++i) {
+        if (quads[i].res != nullptr && vars.count(quads[i].res->val) > 0)
+            tagWrites[i] = true;
+    }
+}
+
+void Executor::setType(uint32_t pc, SymbolInfo* sym, uint8_t type) {
+    if (tagAll || tagWrites[pc])
+        varTypes[sym->val] = type;
+}
+
+// Next non-whitespace char
+int64_t Executor::readChar() {
+    char c = 0;
+    std::cin >> std::ws >> c;
+    return static_cast<int64_t>(c);
+}
+
+// Read a token and try to interpret it
+int64_t Executor::readToken(uint8_t& type) {
+    std::string token;
+    if (!(std::cin >> token)) {
+        // input failure, default to 0
+        type = SymbolInfo::NUMBER;
+        return 0;
+    }
+    // token like 'a'
+    if (token.size() >= 3 && token.front() == 39 && token.back() == 39) {
+        type = SymbolInfo::CHAR;
+        return static_cast<int64_t>(token[1]);
+    }
+    // try parse integer
+    try {
+        long long v = std::stoll(token);
+        type = SymbolInfo::NUMBER;
+        return static_cast<int64_t>(v);
+    } catch (...) {
+        // fallback: if single char token, store as char; otherwise store first char
+        type = SymbolInfo::CHAR;
+        return static_cast<int64_t>(token[0]);
+    }
+}
+
 void Executor::PrintQuads() {
     std::cout << "\n=== Generated Quads ===" << std::endl;
     for (uint32_t i = 0; i < quads.size(); ++i) {
@@ -123,6 +208,7 @@ void Executor::printQuad(const Quad& quad, uint32_t index) {
             case SymbolInfo::MINUS: std::cout << "-"; break;
             case SymbolInfo::MULTI: std::cout << "*"; break;
             case SymbolInfo::SLASH: std::cout << "/"; break;
+            case SymbolInfo::SLASH_UNCHECKED: std::cout << "/!"; break;
             case SymbolInfo::EQUALS: std::cout << "="; break;
             case SymbolInfo::LESS: std::cout << "<"; break;
             case SymbolInfo::MORE: std::cout << ">"; break;
@@ -147,6 +233,24 @@ void Executor::printQuad(const Quad& quad, uint32_t index) {
         else if (quad.op->val == SymbolInfo::PRINT) {
             std::cout << "PRINT";
         }
+        else if (quad.op->val == SymbolInfo::PRINT_NUMBER) {
+            std::cout << "PRINT_NUM";
+        }
+        else if (quad.op->val == SymbolInfo::PRINT_CHAR) {
+            std::cout << "PRINT_CHAR";
+        }
+        else if (quad.op->val == SymbolInfo::READ_NUMBER) {
+            std::cout << "READ_NUM";
+        }
+        else if (quad.op->val == SymbolInfo::READ_CHAR) {
+            std::cout << "READ_CHAR";
+        }
+        else if (quad.op->val == SymbolInfo::SLEEP) {
+            std::cout << "SLEEP";
+        }
+        else if (quad.op->val == SymbolInfo::YIELD) {
+            std::cout << "YIELD";
+        }
     }
     else if (quad.op->code == SymbolInfo::LOOP) {
         if (quad.op->val == 999) {
@@ -159,6 +263,12 @@ void Executor::printQuad(const Quad& quad, uint32_t index) {
             std::cout << "CONTINUE";
         }
     }
+    else if (quad.op->code == SymbolInfo::ARRAY) {
+        static const char* names[] = { "DECLARE", "FILL", "COPY", "LOAD", "STORE", "PRINT_RANGE",
+                                       "STORE_NUM", "STORE_CHAR", "FILL_NUM", "FILL_CHAR" };
+        if (quad.op->val < sizeof(names) / sizeof(names[0])) std::cout << names[quad.op->val];
+        else std::cout << "ARRAY_" << (int)quad.op->val;
+    }
     else {
         std::cout << "OP_" << (int)quad.op->code << "_" << (int)quad.op->val;
     }
@@ -172,20 +282,477 @@ void Executor::printQuad(const Quad& quad, uint32_t index) {
 }
 
 void Executor::Execute() {
+    Bytecode* bytecode = Lower();
+    Execute(*bytecode);
+    delete bytecode;
+}
+
+void Executor::Execute(const Bytecode& bytecode) {
+    if(DEBUG){
+        bytecode.Print();
+        std::cout << "=== Executing Bytecode ===" << std::endl;
+    }
+
+    VMState vm;
+    reset(bytecode, vm);
+
+    // Tracing and stepping interleave program output with their own
+    out = new Output(mode == EXEC_TRACING || mode == EXEC_STEPPING ? FLUSH_ALWAYS : flushPolicy, writer);
+    input = customIO ? new Input(reader) : new Input(batchInput, batchPath);
+    if (!customIO && !input->Interactive() && !input->Opened() && ERROR)
+        std::cout << "ERROR: could not open " << batchPath << ", reading nothing" << std::endl;
+
+    // Copies the registers back to the variable map printVars shows
+    auto syncVars = [&]() {
+        for (uint32_t i = 0; i < bytecode.slotVars.size(); ++i) {
+            variables[bytecode.slotVars[i]] = vm.regs[i];
+            varTypes[bytecode.slotVars[i]] = vm.types[i];
+        }
+    };
+
+    // The JIT only replaces the fast loop, the other modes and machines
+    // without a JIT interpret
+    bool compiled = false;
+    if (useJit && mode == EXEC_FAST && profile == nullptr && Jit::Supported()) {
+        Jit* jit = new Jit(bytecode);
+        compiled = jit->Compile();
+        if (compiled) {
+            if(DEBUG)
+                std::cout << "(compiled to " << jit->CodeSize() << " bytes of machine code)" << std::endl;
+            jit->input = input;
+            jit->output = out;
+            jit->Run(vm.regs.data(), vm.types.data(), 0);
+        }
+        delete jit;
+    }
+
+    if (compiled) {
+        // Already ran
+    }
+    else if (tiered && mode == EXEC_FAST && profile == nullptr && Jit::Supported()) {
+        Bytecode* plain = new Bytecode(quads, tagAll, tagWrites);
+        {
+            TieringPolicy policy(bytecode, *plain);
+            runWith(bytecode, vm, policy);
+            if (policy.osrPc != UINT32_MAX) {
+                if(DEBUG)
+                    std::cout << "(entering machine code at " << policy.osrPc << ")" << std::endl;
+                policy.jit->input = input;
+                policy.jit->output = out;
+                policy.jit->Run(vm.regs.data(), vm.types.data(), policy.osrPc);
+            }
+        }
+        delete plain;
+    }
+    else if (mode == EXEC_STEPPING) {
+        StepPolicy policy(bytecode, [&]() { syncVars(); printVars(); });
+        runWith(bytecode, vm, policy);
+    }
+    else if (mode == EXEC_TRACING) {
+        TracePolicy policy(bytecode);
+        runWith(bytecode, vm, policy);
+    }
+    else if (mode == EXEC_COUNTING || profile != nullptr) {
+        if (profile != nullptr) profile->Begin();
+        CountingPolicy policy(profile);
+        runWith(bytecode, vm, policy);
+        if (mode == EXEC_COUNTING) {
+            std::cout << std::endl;
+            policy.Print();
+        }
+    }
+    else {
+        FastPolicy policy;
+        runWith(bytecode, vm, policy);
+    }
+
+    delete out;
+    out = nullptr;
+    delete input;
+    input = nullptr;
+
+    if(DEBUG){
+        syncVars();
+        std::cout << "\n=== Execution Complete ===" << std::endl;
+        std::cout << "Final ";
+        printVars();
+    }
+}
+
+void Executor::reset(const Bytecode& bc, VMState& vm) {
+    vm.regs.assign(bc.slotVars.size(), 0);
+    vm.regs.insert(vm.regs.end(), bc.constants.begin(), bc.constants.end());
+    vm.regs.resize(vm.regs.size() + bc.cells, 0);
+    vm.types.assign(vm.regs.size(), SymbolInfo::NUMBER);
+    vm.pc = 0;
+}
+
+// Slices end at loop headers and before waits, which a superinstruction
+// could run past, so green threads run the plain opcodes
+void Executor::Start() {
+    sliced = new Bytecode(quads, tagAll, tagWrites);
+    sliceState = new VMState();
+    reset(*sliced, *sliceState);
+    slicer = new SlicePolicy(*sliced);
+}
+
+uint8_t Executor::Slice(int64_t budget, Output* to, Input* from, int64_t& sleepMs) {
+    out = to;
+    input = from;
+    slicer->budget = budget;
+    slicer->stop = SlicePolicy::STOP_NONE;
+    runWith(*sliced, *sliceState, *slicer);
+    out = nullptr;
+    input = nullptr;
+
+    // Headers and reads run when the thread continues, the scheduler does
+    // the waits in its place
+    uint8_t stop = slicer->stop;
+    const Instr& in = sliced->code[slicer->stopPc];
+    if (stop == SlicePolicy::STOP_HEADER || stop == SlicePolicy::STOP_READ) {
+        sliceState->pc = slicer->stopPc;
+        slicer->resuming = true;
+    }
+    else if (stop != SlicePolicy::STOP_NONE) {
+        sliceState->pc = slicer->stopPc + 1;
+        if (stop == SlicePolicy::STOP_SLEEP)
+            sleepMs = (in.flags & IMM_A) ? in.a : sliceState->regs[static_cast<uint32_t>(in.a)];
+    }
+    return stop;
+}
+
+// Without labels as values the switch loop is used either way
+void Executor::SetThreadedDispatch(bool threaded) {
+    threadedDispatch = threaded;
+}
+
+void Executor::SetSuperinstructions(bool fuse) {
+    superinstructions = fuse;
+}
+
+void Executor::SetProfile(PairProfile* pairProfile) {
+    profile = pairProfile;
+}
+
+void Executor::SetMode(ExecutionMode execMode) {
+    mode = execMode;
+}
+
+void Executor::SetJit(bool jit) {
+    useJit = jit;
+}
+
+void Executor::SetTiered(bool tiers) {
+    tiered = tiers;
+}
+
+void Executor::SetFlushPolicy(uint8_t policy) {
+    flushPolicy = policy;
+}
+
+void Executor::SetBatchInput(bool batch, const std::string& path) {
+    batchInput = batch;
+    batchPath = path;
+}
+
+void Executor::SetIO(const Input::Source& read, const Output::Sink& write) {
+    customIO = true;
+    reader = read;
+    writer = write;
+}
+
+// Tracing and stepping show every instruction and the JIT compiles the
+// plain opcodes, so these do not fuse
+Bytecode* Executor::Lower() {
+    Bytecode* bytecode = new Bytecode(quads, tagAll, tagWrites);
+    if (superinstructions && !useJit && mode != EXEC_TRACING && mode != EXEC_STEPPING) bytecode->Fuse();
+    return bytecode;
+}
+
+template<class Policy>
+void Executor::runWith(const Bytecode& bc, VMState& vm, Policy& policy) {
+    if (threadedDispatch) run<true>(bc, vm, policy);
+    else run<false>(bc, vm, policy);
+}
+
+// Labels as values are a GCC/Clang extension, other compilers use the switch
+#if defined(__GNUC__) && !defined(NO_THREADED_DISPATCH)
+#define THREADED_DISPATCH
+#endif
+
+// One loop body with two ways of getting from one handler to the next:
+// back to the switch at the top of the loop, or (THREADED) straight to the
+// next instruction's handler through a table of label addresses indexed
+// by opcode. Bytecode ends with OP_HALT, so no bounds check is needed.
+// Every opcode's work is a BODY_ macro so superinstructions can run
+// several of them in a row, fetching the operands of the next
+// instruction in between but dispatching only once.
+// The policy sees every dispatch and can stop the program.
+template<bool THREADED, class Policy>
+void Executor::run(const Bytecode& bc, VMState& vm, Policy& policy) {
+    const Instr* code = bc.code.data();
+    const ArrayInfo* arrays = bc.arrays.data();
+    Output* o = out;
+    int64_t* r = vm.regs.data();
+    uint8_t* types = vm.types.data();
+    const Instr* in;
+    int64_t a, b;
+
+#define FETCH() \
+    in = &code[vm.pc++]; \
+    a = (in->flags & IMM_A) ? in->a : r[static_cast<uint32_t>(in->a)]; \
+    b = (in->flags & IMM_B) ? in->b : r[static_cast<uint32_t>(in->b)]
+#define DECODE() \
+    FETCH(); \
+    if (Policy::ACTIVE && !policy.Dispatch(in)) return
+
+#define BODY_MOV r[in->dst] = a
+#define BODY_ADD r[in->dst] = a + b
+#define BODY_SUB r[in->dst] = a - b
+#define BODY_MUL r[in->dst] = a * b
+#define BODY_DIV \
+    if (b == 0) { \
+        o->Text("ERROR: Division by zero!\n"); \
+        return; \
+    } \
+    r[in->dst] = a / b
+#define BODY_DIV_UNCHECKED r[in->dst] = a / b
+#define BODY_LT r[in->dst] = a < b
+#define BODY_GT r[in->dst] = a > b
+#define BODY_EQ r[in->dst] = a == b
+#define BODY_NE r[in->dst] = a != b
+#define BODY_LE r[in->dst] = a <= b
+#define BODY_GE r[in->dst] = a >= b
+#define BODY_AND r[in->dst] = a && b
+#define BODY_OR r[in->dst] = a || b
+#define BODY_JMP vm.pc = in->dst
+#define BODY_JNZ if (a != 0) vm.pc = in->dst
+#define BODY_PRINT \
+    if (types[in->a] == SymbolInfo::CHAR) o->PrintChar(a); \
+    else o->PrintNumber(a)
+#define BODY_PRINT_NUM o->PrintNumber(a)
+#define BODY_PRINT_CHAR o->PrintChar(a)
+#define BODY_PRINT_LINE o->PrintLine(a)
+#define BODY_READ_AS(op) { \
+    if (input->Interactive()) { \
+        o->Text("Input: "); \
+        o->BeforeWait(); \
+    } \
+    bool asChar = op == OP_READ_CHAR || (op == OP_READ && types[in->dst] == SymbolInfo::CHAR); \
+    uint8_t type = SymbolInfo::CHAR; \
+    r[in->dst] = asChar ? input->Char() : input->Token(type); \
+    types[in->dst] = type; \
+}
+#define BODY_READ BODY_READ_AS(OP_READ)
+#define BODY_READ_NUM BODY_READ_AS(OP_READ_NUM)
+#define BODY_READ_CHAR BODY_READ_AS(OP_READ_CHAR)
+#define BODY_READ_DISCARD { \
+    if (input->Interactive()) o->BeforeWait(); \
+    input->Skip(); \
+}
+#define BODY_SLEEP { \
+    o->BeforeWait(); \
+    sleepFor(a); \
+}
+#define BODY_YIELD std::this_thread::yield()
+#define ARRAY_RANGE_ERROR { \
+    o->Text("ERROR: Array index out of range!\n"); \
+    return; \
+}
+#define BODY_ALOAD { \
+    const ArrayInfo& ar = arrays[in->a]; \
+    if (static_cast<uint64_t>(b) >= ar.size) ARRAY_RANGE_ERROR \
+    r[in->dst] = r[ar.base + b]; \
+    types[in->dst] = types[ar.base + b]; \
+}
+#define BODY_ASTORE { \
+    const ArrayInfo& ar = arrays[in->dst]; \
+    if (static_cast<uint64_t>(a) >= ar.size) ARRAY_RANGE_ERROR \
+    r[ar.base + a] = b; \
+    types[ar.base + a] = in->pad != 0 ? in->pad : types[in->b]; \
+}
+#define BODY_AFILL { \
+    const ArrayInfo& ar = arrays[in->dst]; \
+    ArrayOps::Fill(r + ar.base, types + ar.base, ar.size, a, in->pad != 0 ? in->pad : types[in->a]); \
+}
+#define BODY_ACOPY { \
+    const ArrayInfo& ar = arrays[in->dst]; \
+    const ArrayInfo& src = arrays[a]; \
+    ArrayOps::Copy(r + ar.base, types + ar.base, r + src.base, types + src.base, std::min(ar.size, src.size)); \
+}
+#define BODY_APRINT { \
+    const ArrayInfo& ar = arrays[in->dst]; \
+    if (static_cast<uint64_t>(a) > ar.size || static_cast<uint64_t>(b) > ar.size - a) ARRAY_RANGE_ERROR \
+    o->PrintRange(r + ar.base + a, types + ar.base + a, static_cast<uint32_t>(b)); \
+}
+#define BODY_SET_TYPE types[in->dst] = static_cast<uint8_t>(a)
+#define BODY_COPY_TYPE types[in->dst] = types[in->a]
+#define BODY_HALT return
+
+#ifdef THREADED_DISPATCH
+    // In Opcode order
+#define SUPER_PAIR(x, y) &&L_OP_##x##_##y,
+#define SUPER_TRIPLE(x, y, z) &&L_OP_##x##_##y##_##z,
+    static void* const handlers[] = {
+        &&L_OP_MOV, &&L_OP_ADD, &&L_OP_SUB, &&L_OP_MUL, &&L_OP_DIV, &&L_OP_DIV_UNCHECKED,
+        &&L_OP_LT, &&L_OP_GT, &&L_OP_EQ, &&L_OP_NE, &&L_OP_LE, &&L_OP_GE, &&L_OP_AND, &&L_OP_OR,
+        &&L_OP_JMP, &&L_OP_JNZ, &&L_OP_PRINT, &&L_OP_PRINT_NUM, &&L_OP_PRINT_CHAR, &&L_OP_PRINT_LINE,
+        &&L_OP_READ, &&L_OP_READ_NUM, &&L_OP_READ_CHAR, &&L_OP_READ_DISCARD, &&L_OP_SLEEP, &&L_OP_YIELD,
+        &&L_OP_ALOAD, &&L_OP_ASTORE, &&L_OP_AFILL, &&L_OP_ACOPY, &&L_OP_APRINT,
+        &&L_OP_SET_TYPE, &&L_OP_COPY_TYPE, &&L_OP_HALT,
+        SUPER_PAIRS(SUPER_PAIR)
+        SUPER_TRIPLES(SUPER_TRIPLE)
+    };
+#undef SUPER_PAIR
+#undef SUPER_TRIPLE
+    static_assert(sizeof(handlers) / sizeof(handlers[0]) == OP_COUNT, "handler table out of date");
+#define HANDLER(op) case op: L_##op
+#define NEXT \
+    if (THREADED) { DECODE(); goto *handlers[in->op]; } \
+    continue
+#else
+#define HANDLER(op) case op
+#define NEXT continue
+#endif
+
+    for (;;) {
+        DECODE();
+        switch (in->op) {
+            HANDLER(OP_MOV): BODY_MOV; NEXT;
+            HANDLER(OP_ADD): BODY_ADD; NEXT;
+            HANDLER(OP_SUB): BODY_SUB; NEXT;
+            HANDLER(OP_MUL): BODY_MUL; NEXT;
+            HANDLER(OP_DIV): BODY_DIV; NEXT;
+            HANDLER(OP_DIV_UNCHECKED): BODY_DIV_UNCHECKED; NEXT;
+            HANDLER(OP_LT): BODY_LT; NEXT;
+            HANDLER(OP_GT): BODY_GT; NEXT;
+            HANDLER(OP_EQ): BODY_EQ; NEXT;
+            HANDLER(OP_NE): BODY_NE; NEXT;
+            HANDLER(OP_LE): BODY_LE; NEXT;
+            HANDLER(OP_GE): BODY_GE; NEXT;
+            HANDLER(OP_AND): BODY_AND; NEXT;
+            HANDLER(OP_OR): BODY_OR; NEXT;
+            HANDLER(OP_JMP): BODY_JMP; NEXT;
+            HANDLER(OP_JNZ): BODY_JNZ; NEXT;
+            HANDLER(OP_PRINT): BODY_PRINT; NEXT;
+            HANDLER(OP_PRINT_NUM): BODY_PRINT_NUM; NEXT;
+            HANDLER(OP_PRINT_CHAR): BODY_PRINT_CHAR; NEXT;
+            HANDLER(OP_PRINT_LINE): BODY_PRINT_LINE; NEXT;
+            HANDLER(OP_READ): BODY_READ; NEXT;
+            HANDLER(OP_READ_NUM): BODY_READ_NUM; NEXT;
+            HANDLER(OP_READ_CHAR): BODY_READ_CHAR; NEXT;
+            HANDLER(OP_READ_DISCARD): BODY_READ_DISCARD; NEXT;
+            HANDLER(OP_SLEEP): BODY_SLEEP; NEXT;
+            HANDLER(OP_YIELD): BODY_YIELD; NEXT;
+            HANDLER(OP_ALOAD): BODY_ALOAD; NEXT;
+            HANDLER(OP_ASTORE): BODY_ASTORE; NEXT;
+            HANDLER(OP_AFILL): BODY_AFILL; NEXT;
+            HANDLER(OP_ACOPY): BODY_ACOPY; NEXT;
+            HANDLER(OP_APRINT): BODY_APRINT; NEXT;
+            HANDLER(OP_SET_TYPE): BODY_SET_TYPE; NEXT;
+            HANDLER(OP_COPY_TYPE): BODY_COPY_TYPE; NEXT;
+            HANDLER(OP_HALT): BODY_HALT;
+#define SUPER_PAIR(x, y) \
+            HANDLER(OP_##x##_##y): BODY_##x; FETCH(); BODY_##y; NEXT;
+#define SUPER_TRIPLE(x, y, z) \
+            HANDLER(OP_##x##_##y##_##z): BODY_##x; FETCH(); BODY_##y; FETCH(); BODY_##z; NEXT;
+            SUPER_PAIRS(SUPER_PAIR)
+            SUPER_TRIPLES(SUPER_TRIPLE)
+#undef SUPER_PAIR
+#undef SUPER_TRIPLE
+            default: return;
+        }
+    }
+#undef FETCH
+#undef DECODE
+#undef HANDLER
+#undef NEXT
+}
+
+// Array quads of ExecuteQuads. Elements keep their own type like variables
+// do, a stored variable brings the type it was last given.
+bool Executor::executeArrayQuad(uint32_t pc) {
+    const Quad& quad = quads[pc];
+    uint64_t array = quad.op->val == SymbolInfo::LOAD ? quad.arg1->val : quad.res->val;
+    std::vector<int64_t>& values = arrayValues[array];
+    std::vector<uint8_t>& types = arrayTypes[array];
+    uint8_t type = SymbolInfo::NUMBER;
+    if (quad.op->val == SymbolInfo::STORE_CHAR || quad.op->val == SymbolInfo::FILL_CHAR) type = SymbolInfo::CHAR;
+    else if (quad.arg1 != nullptr && quad.arg1->code == SymbolInfo::CHAR) type = SymbolInfo::CHAR;
+    else if (quad.arg1 != nullptr && quad.arg1->code == SymbolInfo::VARIABLE &&
+             quad.op->val != SymbolInfo::STORE_NUMBER && quad.op->val != SymbolInfo::FILL_NUMBER) {
+        auto it = varTypes.find(quad.arg1->val);
+        if (it != varTypes.end()) type = it->second;
+    }
+
+    switch (quad.op->val) {
+        case SymbolInfo::DECLARE:
+            values.assign(getValue(quad.arg1), 0);
+            types.assign(values.size(), SymbolInfo::NUMBER);
+            return true;
+        case SymbolInfo::LOAD: {
+            uint64_t index = getValue(quad.arg2);
+            if (index >= values.size()) break;
+            setValue(quad.res, values[index]);
+            setType(pc, quad.res, types[index]);
+            return true;
+        }
+        case SymbolInfo::STORE: case SymbolInfo::STORE_NUMBER: case SymbolInfo::STORE_CHAR: {
+            uint64_t index = getValue(quad.arg2);
+            if (index >= values.size()) break;
+            values[index] = getValue(quad.arg1);
+            types[index] = type;
+            return true;
+        }
+        case SymbolInfo::FILL: case SymbolInfo::FILL_NUMBER: case SymbolInfo::FILL_CHAR:
+            std::fill(values.begin(), values.end(), getValue(quad.arg1));
+            std::fill(types.begin(), types.end(), type);
+            return true;
+        case SymbolInfo::COPY: {
+            const std::vector<int64_t>& srcValues = arrayValues[quad.arg1->val];
+            const std::vector<uint8_t>& srcTypes = arrayTypes[quad.arg1->val];
+            size_t n = std::min(values.size(), srcValues.size());
+            std::copy(srcValues.begin(), srcValues.begin() + n, values.begin());
+            std::copy(srcTypes.begin(), srcTypes.begin() + n, types.begin());
+            return true;
+        }
+        case SymbolInfo::PRINT_RANGE: {
+            uint64_t from = getValue(quad.arg1), count = getValue(quad.arg2);
+            if (from > values.size() || count > values.size() - from) break;
+            for (uint64_t i = from; i < from + count; ++i) {
+                if (PRINT_NEWLINE) std::cout << "Output: ";
+                if (types[i] == SymbolInfo::CHAR) std::cout << static_cast<char>(values[i]);
+                else std::cout << values[i];
+                if (PRINT_NEWLINE) std::cout << std::endl;
+            }
+            return true;
+        }
+        default:
+            return true;
+    }
+    std::cout << "ERROR: Array index out of range!" << std::endl;
+    return false;
+}
+
+void Executor::ExecuteQuads() {
     if(DEBUG)
         std::cout << "\n=== Executing Quads ===" << std::endl;
 
+    // Only the quad interpreter jumps to labels, bytecode has instruction indices
+    buildLabelMap();
+
+    // Arrays exist from the start, a declaration only zeroes them
+    for (const Quad& quad : quads) {
+        if (isArrayQuad(quad) && quad.op->val == SymbolInfo::DECLARE) {
+            arrayValues[quad.res->val].assign(quad.arg1->val, 0);
+            arrayTypes[quad.res->val].assign(quad.arg1->val, SymbolInfo::NUMBER);
+        }
+    }
+
     uint32_t pc = 0;  // Program counter
     while (pc < quads.size()) {
         const Quad& quad = quads[pc];
 
-        if(RUNTIME_DEBUGGING){
-            std::cout << std::endl << "Quad: " << pc << std::endl;
-            printVars();
-            std::cout << "Press Enter to continue...";
-            std::cin.get();
-        }
-
         // Skip label quads (they're just markers)
         if (quad.op == nullptr && quad.res != nullptr && isLabel(quad.res)) {
             pc++;
@@ -221,54 +788,55 @@ void Executor::Execute() {
                 // If condition is false, fall through to next instruction
             }
         }
-        else if (quad.op->code == SymbolInfo::CONSOLE && quad.op->val == SymbolInfo::READ) {
+        else if (quad.op->code == SymbolInfo::CONSOLE && (quad.op->val == SymbolInfo::READ ||
+                 quad.op->val == SymbolInfo::READ_NUMBER || quad.op->val == SymbolInfo::READ_CHAR)) {
             if (quad.res != nullptr) {
                 std::cout << "Input: ";
                 // If destination is known to be CHAR, read single char
-                auto itType = varTypes.find(quad.res->val);
-                if (itType != varTypes.end() && itType->second == SymbolInfo::CHAR) {
-                    char c;
-                    std::cin >> std::ws >> c; // read next non-whitespace char
-                    setValue(quad.res, static_cast<int64_t>(c));
-                    varTypes[quad.res->val] = SymbolInfo::CHAR;
-                } else {
-                    // Read a token and try to interpret it
-                    std::string token;
-                    if (!(std::cin >> token)) {
-                        // input failure, default to 0
-                        setValue(quad.res, 0);
-                        varTypes[quad.res->val] = SymbolInfo::NUMBER;
-                    } else {
-                        // token like 'a'
-                        if (token.size() >= 3 && token.front() == 39 && token.back() == 39) {
-                            char c = token[1];
-                            setValue(quad.res, static_cast<int64_t>(c));
-                            varTypes[quad.res->val] = SymbolInfo::CHAR;
-                        } else {
-                            // try parse integer
-                            try {
-                                long long v = std::stoll(token);
-                                setValue(quad.res, static_cast<int64_t>(v));
-                                varTypes[quad.res->val] = SymbolInfo::NUMBER;
-                            } catch (...) {
-                                // fallback: if single char token, store as char; otherwise store first char
-                                if (!token.empty()) {
-                                    setValue(quad.res, static_cast<int64_t>(token[0]));
-                                    varTypes[quad.res->val] = SymbolInfo::CHAR;
-                                } else {
-                                    setValue(quad.res, 0);
-                                    varTypes[quad.res->val] = SymbolInfo::NUMBER;
-                                }
-                            }
-                        }
-                    }
+                bool asChar = quad.op->val == SymbolInfo::READ_CHAR;
+                if (quad.op->val == SymbolInfo::READ) {
+                    auto itType = varTypes.find(quad.res->val);
+                    asChar = itType != varTypes.end() && itType->second == SymbolInfo::CHAR;
                 }
+                uint8_t type = SymbolInfo::CHAR;
+                int64_t value = asChar ? readChar() : readToken(type);
+                setValue(quad.res, value);
+                setType(pc, quad.res, type);
             } else {
                 // read is used standalone, consume a token and discard
                 std::string tmp;
                 std::cin >> tmp;
             }
         }
+        else if (quad.op->code == SymbolInfo::CONSOLE && quad.op->val == SymbolInfo::SLEEP) {
+            std::cout.flush();
+            sleepFor(getValue(quad.arg1));
+            pc++;
+            continue;
+        }
+        else if (quad.op->code == SymbolInfo::CONSOLE && quad.op->val == SymbolInfo::YIELD) {
+            std::this_thread::yield();
+            pc++;
+            continue;
+        }
+        else if (quad.op->code == SymbolInfo::CONSOLE && quad.op->val == SymbolInfo::PRINT_CHAR) {
+            char c = static_cast<char>(getValue(quad.arg1));
+
+            if(PRINT_NEWLINE)
+                std::cout << "Output: " << c << std::endl;
+            else  std::cout << c;
+            pc++;
+            continue;
+        }
+        else if (quad.op->code == SymbolInfo::CONSOLE && quad.op->val == SymbolInfo::PRINT_NUMBER) {
+            int64_t value = getValue(quad.arg1);
+
+            if(PRINT_NEWLINE)
+                std::cout << "Output: " << value << std::endl;
+            else  std::cout << value;
+            pc++;
+            continue;
+        }
         else if (quad.op->code == SymbolInfo::CONSOLE && quad.op->val == SymbolInfo::PRINT) {
             if (quad.arg1 != nullptr) {
                 // If it's a char literal, print as char
@@ -306,11 +874,20 @@ void Executor::Execute() {
             continue;
         }
 
+        if (quad.op->code == SymbolInfo::ARRAY) {
+            if (!executeArrayQuad(pc)) return;
+            pc++;
+            continue;
+        }
+
         // Assignment operation
         if (quad.op->code == SymbolInfo::OPERATOR && quad.op->val == SymbolInfo::EQUALS) {
             if (quad.res != nullptr && quad.arg1 != nullptr) {
                 // Propagate type information
-                if (quad.arg1->code == SymbolInfo::NUMBER) {
+                if (!tagAll && !tagWrites[pc]) {
+                    // Type is known statically
+                }
+                else if (quad.arg1->code == SymbolInfo::NUMBER) {
                     varTypes[quad.res->val] = SymbolInfo::NUMBER;
                 }
                 else if (quad.arg1->code == SymbolInfo::CHAR) {
@@ -354,6 +931,9 @@ void Executor::Execute() {
                     }
                     result = arg1Val / arg2Val;
                     break;
+                case SymbolInfo::SLASH_UNCHECKED:
+                    result = arg1Val / arg2Val;
+                    break;
                 case SymbolInfo::LESS:
                     result = (arg1Val < arg2Val) ? 1 : 0;
                     break;
@@ -368,7 +948,7 @@ void Executor::Execute() {
             if (quad.res != nullptr) {
                 setValue(quad.res, result);
                 // Arithmetic results are numeric
-                varTypes[quad.res->val] = SymbolInfo::NUMBER;
+                setType(pc, quad.res, SymbolInfo::NUMBER);
             }
             pc++;
             continue;
@@ -407,7 +987,7 @@ void Executor::Execute() {
             if (quad.res != nullptr) {
                 setValue(quad.res, result);
                 // Relational results are numeric (0/1)
-                varTypes[quad.res->val] = SymbolInfo::NUMBER;
+                setType(pc, quad.res, SymbolInfo::NUMBER);
             }
             pc++;
             continue;
@@ -2,29 +2,102 @@
 #define EXECUTOR_H
 
 #include <map>
+#include <set>
 #include <vector>
 #include <string>
 #include "synt.h"
+#include "bytecode.h"
+#include "pairProfile.h"
+#include "output.h"
+#include "input.h"
+
+struct SlicePolicy;
+
+// How Execute runs the bytecode, each one a separately compiled VM loop
+enum ExecutionMode : uint8_t {
+    EXEC_FAST,      // Just the program
+    EXEC_COUNTING,  // Print how often each opcode ran
+    EXEC_TRACING,   // Print every instruction before it runs
+    EXEC_STEPPING   // Interactive step debugger
+};
 
 class Executor {
 public:
     Executor(std::vector<Quad>& quads);
     ~Executor();
-    void Execute();
+    void Execute();       // Lower the quads to bytecode and run it
+    void Execute(const Bytecode& bytecode);  // Run what Lower gave with the same settings
+    void ExecuteQuads();  // Interpret the quads directly
+    Bytecode* Lower();    // Bytecode Execute runs, owned by the caller
+    void SetThreadedDispatch(bool threaded);  // False dispatches through a switch
+    void SetSuperinstructions(bool fuse);     // Defaults to SUPERINSTRUCTIONS
+    void SetProfile(PairProfile* pairProfile);  // Count the instructions Execute dispatches
+    void SetMode(ExecutionMode execMode);     // Defaults to stepping if RUNTIME_DEBUGGING
+    void SetJit(bool jit);                    // Compile to machine code where supported
+    void SetTiered(bool tiers);               // Interpret, then compile once a loop is hot
+    void SetFlushPolicy(uint8_t policy);      // FlushPolicy of the output, defaults to OUTPUT_FLUSH
+    // Unprompted, buffered read() from the file at path, or stdin if it is empty
+    void SetBatchInput(bool batch, const std::string& path);
+    // Execute reads and prints through these instead of std::cin and
+    // std::cout. An empty read is the end of input, an empty write
+    // still goes to std::cout.
+    void SetIO(const Input::Source& read, const Output::Sink& write);
+    // Green thread interface of Scheduler. Start lowers the program and sets
+    // up its registers, each Slice then runs it with budget dispatches and
+    // returns why the slice ended as a SlicePolicy::Stop, STOP_NONE once
+    // the program has finished. sleepMs is the wait of a STOP_SLEEP.
+    void Start();
+    uint8_t Slice(int64_t budget, Output* to, Input* from, int64_t& sleepMs);
     void PrintQuads();  // Debug function to print all quads
+    void SetTaggedVars(const std::set<uint64_t>& vars);  // Only these need runtime types
 private:
+    // State of the bytecode machine
+    struct VMState {
+        std::vector<int64_t> regs;   // Register file, one slot per variable
+        std::vector<uint8_t> types;  // Runtime type of every slot
+        uint32_t pc;
+    };
+
     std::vector<Quad>& quads;
     std::map<uint64_t, int64_t> variables;  // Map variable IDs to their values
     std::map<uint64_t, uint8_t> varTypes;   // Map variable IDs to their stored type (SymbolInfo::NUMBER or SymbolInfo::CHAR)
     std::map<uint64_t, uint32_t> labelMap;  // Map label IDs to quad indices
+    std::map<uint64_t, std::vector<int64_t>> arrayValues;  // Elements of each array of ExecuteQuads
+    std::map<uint64_t, std::vector<uint8_t>> arrayTypes;   // and their runtime types
+    bool threadedDispatch;                  // Jump from handler to handler
+    bool superinstructions;                 // Fuse frequent instruction sequences
+    PairProfile* profile;                   // Not owned, nullptr when not profiling
+    ExecutionMode mode;
+    bool useJit;
+    bool tiered;
+    uint8_t flushPolicy;
+    Output* out;                            // Program output while Execute or a Slice runs
+    bool batchInput;
+    std::string batchPath;
+    Input* input;                           // Input of read() while Execute or a Slice runs
+    bool customIO;                          // SetIO was called
+    Input::Source reader;
+    Output::Sink writer;
+    bool tagAll;                            // Track the runtime type of every variable
+    std::vector<bool> tagWrites;            // Per quad: destination needs its runtime type
+    Bytecode* sliced;                       // Of a green thread, nullptr before Start
+    VMState* sliceState;
+    SlicePolicy* slicer;
     
     int64_t getValue(SymbolInfo* sym);
     void setValue(SymbolInfo* sym, int64_t value);
+    void setType(uint32_t pc, SymbolInfo* sym, uint8_t type);
+    bool executeArrayQuad(uint32_t pc);     // False when an index is out of range
+    int64_t readChar();                     // Input of ExecuteQuads
+    int64_t readToken(uint8_t& type);
     bool isLabel(SymbolInfo* sym);
     uint32_t findLabelIndex(SymbolInfo* label);
     void buildLabelMap();  // Build map of labels to quad indices
     void printQuad(const Quad& quad, uint32_t index);
     void printVars();
+    void reset(const Bytecode& bc, VMState& vm);  // Registers and types before the first instruction
+    template<class Policy> void runWith(const Bytecode& bc, VMState& vm, Policy& policy);
+    template<bool THREADED, class Policy> void run(const Bytecode& bc, VMState& vm, Policy& policy);
 };
 
 #endif
@@ -0,0 +1,132 @@
+#include <iostream>
+#include <cctype>
+#include "input.h"
+#include "symbInfo.h"
+#include "settings.h"
+
+Input::Input(bool batch, const std::string& path) : batch(batch) {
+    source = nullptr;
+    pos = 0;
+    end = 0;
+    if (!batch) return;
+    buf.resize(INPUT_BUFFER);
+    if (path.empty()) {
+        source = std::cin.rdbuf();
+        return;
+    }
+    file.open(path, std::ios::binary);
+    if (file) source = file.rdbuf();
+}
+
+Input::Input(const Source& reader) : batch(true), reader(reader) {
+    source = nullptr;
+    pos = 0;
+    end = 0;
+    buf.resize(CALLBACK_BUFFER);
+}
+
+Input::~Input() {
+    // Destructor
+}
+
+bool Input::fill() {
+    pos = 0;
+    if (reader) end = reader(buf.data(), buf.size());
+    else if (source != nullptr) end = static_cast<size_t>(source->sgetn(buf.data(), buf.size()));
+    else end = 0;
+    return end > 0;
+}
+
+void Input::skipSpace() {
+    int c;
+    while ((c = peek()) != -1 && isspace(c)) ++pos;
+}
+
+void Input::TokenParser::Begin() {
+    length = 0;
+    first = second = last = 0;
+    negative = digits = overflow = stopped = false;
+    magnitude = 0;
+}
+
+// Like std::stoll: an optional sign, then the digits up to the first
+// other char. Out of range is tracked instead of thrown.
+void Input::TokenParser::Feed(char c) {
+    if (length == 0) first = c;
+    else if (length == 1) second = c;
+    last = c;
+    ++length;
+    if (stopped) return;
+    if (length == 1 && (c == '-' || c == '+')) {
+        negative = c == '-';
+        return;
+    }
+    if (c < '0' || c > '9') {
+        stopped = true;
+        return;
+    }
+    digits = true;
+    uint64_t limit = negative ? static_cast<uint64_t>(INT64_MAX) + 1 : INT64_MAX;
+    uint64_t d = c - '0';
+    if (overflow || magnitude > (limit - d) / 10) overflow = true;
+    else magnitude = magnitude * 10 + d;
+}
+
+int64_t Input::TokenParser::End(uint8_t& type) {
+    if (length == 0) {
+        type = SymbolInfo::NUMBER;
+        return 0;
+    }
+    if (length >= 3 && first == '\'' && last == '\'') {
+        type = SymbolInfo::CHAR;
+        return static_cast<int64_t>(second);
+    }
+    if (digits && !overflow) {
+        type = SymbolInfo::NUMBER;
+        return negative ? static_cast<int64_t>(0 - magnitude) : static_cast<int64_t>(magnitude);
+    }
+    type = SymbolInfo::CHAR;
+    return static_cast<int64_t>(first);
+}
+
+int64_t Input::Char() {
+    if (!batch) {
+        char c = 0;
+        std::cin >> std::ws >> c;
+        return static_cast<int64_t>(c);
+    }
+    skipSpace();
+    int c = peek();
+    if (c == -1) return 0;
+    ++pos;
+    return static_cast<int64_t>(static_cast<char>(c));
+}
+
+int64_t Input::Token(uint8_t& type) {
+    TokenParser parser;
+    parser.Begin();
+    if (!batch) {
+        std::string token;
+        if (std::cin >> token)
+            for (char c : token) parser.Feed(c);
+        return parser.End(type);
+    }
+    skipSpace();
+    int c;
+    while ((c = peek()) != -1 && !isspace(c)) {
+        parser.Feed(static_cast<char>(c));
+        ++pos;
+    }
+    return parser.End(type);
+}
+
+void Input::Skip() {
+    if (!batch) {
+        std::string tmp;
+        std::cin >> tmp;
+        return;
+    }
+    skipSpace();
+    int c;
+    while ((c = peek()) != -1 && !isspace(c)) ++pos;
+}
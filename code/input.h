@@ -0,0 +1,56 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Input of read() for the VM and the JIT. Interactive input goes through
+// std::cin and is prompted with "Input: ". Batch input reads stdin or a
+// file through a large buffer, parses tokens in place without allocating
+// and is not prompted. Both parse tokens the same way as
+// Executor::readToken, without exceptions.
+class Input {
+public:
+    // Fills up to n bytes of data, returns how many, 0 at the end
+    typedef std::function<size_t(char* data, size_t n)> Source;
+
+    // path is only used in batch mode, empty for stdin
+    Input(bool batch, const std::string& path);
+    Input(const Source& reader);  // Batch input from reader
+    ~Input();
+
+    bool Interactive() const { return !batch; }
+    bool Opened() const { return source != nullptr; }
+    int64_t Char();                // Next non-whitespace char, 0 at the end
+    int64_t Token(uint8_t& type);  // Number, quoted or other char, NUMBER 0 at the end
+    void Skip();                   // Discard a token
+private:
+    // Reads one token a char at a time, keeping only what the result
+    // depends on
+    struct TokenParser {
+        uint64_t length;
+        char first, second, last;
+        bool negative, digits, overflow, stopped;  // stopped: past the leading number
+        uint64_t magnitude;
+
+        void Begin();
+        void Feed(char c);
+        int64_t End(uint8_t& type);
+    };
+
+    bool batch;
+    std::ifstream file;
+    std::streambuf* source;  // Batch input, nullptr if the file did not open
+    Source reader;           // Instead of source if set
+    std::vector<char> buf;
+    size_t pos, end;
+
+    bool fill();
+    int peek() { return pos < end || fill() ? static_cast<unsigned char>(buf[pos]) : -1; }
+    void skipSpace();
+};
+
+#endif
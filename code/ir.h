@@ -0,0 +1,191 @@
+#ifndef IR_H
+#define IR_H
+
+#include <cstdint>
+#include "synt.h"
+
+// Id ranges the parser uses for labels and temporaries (see Synt::genTempVar)
+const uint64_t LABEL_BASE = 10000;
+const uint64_t TEMP_BASE = 50000;
+const uint64_t GOTO_OP = 999;  // SymbolInfo::LOOP value used for goto
+
+// Helpers for inspecting quads outside of the parser and executor
+
+inline bool isLabelSym(const SymbolInfo* s) {
+    return s != nullptr && s->code == SymbolInfo::VARIABLE &&
+           s->val >= LABEL_BASE && s->val < TEMP_BASE;
+}
+
+inline bool isTempSym(const SymbolInfo* s) {
+    return s != nullptr && s->code == SymbolInfo::VARIABLE && s->val >= TEMP_BASE;
+}
+
+// Variable or temporary (anything with storage)
+inline bool isVarSym(const SymbolInfo* s) {
+    return s != nullptr && s->code == SymbolInfo::VARIABLE && !isLabelSym(s);
+}
+
+// Array operand of an array quad
+inline bool isArraySym(const SymbolInfo* s) {
+    return s != nullptr && s->code == SymbolInfo::ARRAY;
+}
+
+inline bool isConstSym(const SymbolInfo* s) {
+    return s != nullptr && (s->code == SymbolInfo::NUMBER || s->code == SymbolInfo::CHAR);
+}
+
+inline bool sameSym(const SymbolInfo* a, const SymbolInfo* b) {
+    if (a == nullptr || b == nullptr) return a == b;
+    return a->code == b->code && a->val == b->val;
+}
+
+inline bool isOp(const Quad& q, uint8_t code, uint64_t val) {
+    return q.op != nullptr && q.op->code == code && q.op->val == val;
+}
+
+inline bool isLabelQuad(const Quad& q) {
+    return q.op == nullptr && isLabelSym(q.res);
+}
+
+inline bool isNopQuad(const Quad& q) {
+    return q.op == nullptr && q.res == nullptr;
+}
+
+inline bool isGotoQuad(const Quad& q) {
+    return isOp(q, SymbolInfo::LOOP, GOTO_OP);
+}
+
+inline bool isCondGotoQuad(const Quad& q) {
+    return isGotoQuad(q) && q.arg1 != nullptr;
+}
+
+// Arithmetic and relational quads: res = arg1 op arg2
+inline bool isBinaryQuad(const Quad& q) {
+    if (q.op == nullptr) return false;
+    if (q.op->code == SymbolInfo::OPERATOR)
+        return q.op->val == SymbolInfo::PLUS || q.op->val == SymbolInfo::MINUS ||
+               q.op->val == SymbolInfo::MULTI || q.op->val == SymbolInfo::SLASH ||
+               q.op->val == SymbolInfo::SLASH_UNCHECKED ||
+               q.op->val == SymbolInfo::LESS || q.op->val == SymbolInfo::MORE;
+    return q.op->code == SymbolInfo::OPERATOR2 && q.op->val != SymbolInfo::LINE_COMMENT &&
+           q.op->val != SymbolInfo::INCREMENT && q.op->val != SymbolInfo::DECREMENT;
+}
+
+inline bool isCommutativeQuad(const Quad& q) {
+    if (q.op == nullptr) return false;
+    if (q.op->code == SymbolInfo::OPERATOR)
+        return q.op->val == SymbolInfo::PLUS || q.op->val == SymbolInfo::MULTI;
+    return q.op->code == SymbolInfo::OPERATOR2 &&
+           (q.op->val == SymbolInfo::LOGICAL_EQUALS || q.op->val == SymbolInfo::NOT_EQUALS ||
+            q.op->val == SymbolInfo::AND || q.op->val == SymbolInfo::OR);
+}
+
+// Comparisons and logical operators, whose result is always 0 or 1
+inline bool isBoolQuad(const Quad& q) {
+    if (!isBinaryQuad(q)) return false;
+    if (q.op->code == SymbolInfo::OPERATOR)
+        return q.op->val == SymbolInfo::LESS || q.op->val == SymbolInfo::MORE;
+    return true;
+}
+
+inline bool isAssignQuad(const Quad& q) {
+    return isOp(q, SymbolInfo::OPERATOR, SymbolInfo::EQUALS);
+}
+
+// read() and its typed variants
+inline bool isReadQuad(const Quad& q) {
+    return q.op != nullptr && q.op->code == SymbolInfo::CONSOLE &&
+           (q.op->val == SymbolInfo::READ || q.op->val == SymbolInfo::READ_NUMBER ||
+            q.op->val == SymbolInfo::READ_CHAR);
+}
+
+// print() and its typed variants
+inline bool isPrintQuad(const Quad& q) {
+    return q.op != nullptr && q.op->code == SymbolInfo::CONSOLE &&
+           (q.op->val == SymbolInfo::PRINT || q.op->val == SymbolInfo::PRINT_NUMBER ||
+            q.op->val == SymbolInfo::PRINT_CHAR);
+}
+
+// sleep(ms) and yield(), which only hand the processor to others
+inline bool isWaitQuad(const Quad& q) {
+    return q.op != nullptr && q.op->code == SymbolInfo::CONSOLE &&
+           (q.op->val == SymbolInfo::SLEEP || q.op->val == SymbolInfo::YIELD);
+}
+
+// Quads on arrays, see SymbolInfo::Arrays:
+//   DECLARE size -> arr      LOAD arr, index -> var    STORE value, index -> arr
+//   FILL value -> arr        COPY src -> arr           PRINT_RANGE from, count -> arr
+// Arrays are not variables, so the passes only see the scalars they use
+// and the variable LOAD writes.
+inline bool isArrayQuad(const Quad& q) {
+    return q.op != nullptr && q.op->code == SymbolInfo::ARRAY;
+}
+
+// Variable written by the quad, or nullptr
+inline SymbolInfo* quadDef(const Quad& q) {
+    if (q.op == nullptr || isGotoQuad(q)) return nullptr;
+    if (q.op->code == SymbolInfo::CONSOLE && !isReadQuad(q)) return nullptr;
+    return isVarSym(q.res) ? q.res : nullptr;
+}
+
+// Variables read by the quad. READ counts as a use of its destination
+// because the executor looks at its current type to pick the input format.
+inline uint8_t quadUses(const Quad& q, SymbolInfo* out[2]) {
+    uint8_t n = 0;
+    if (q.op == nullptr) return 0;
+    if (isBinaryQuad(q)) {
+        if (isVarSym(q.arg1)) out[n++] = q.arg1;
+        if (isVarSym(q.arg2)) out[n++] = q.arg2;
+    }
+    else if (isReadQuad(q)) {
+        if (isVarSym(q.res)) out[n++] = q.res;
+    }
+    else if (isArrayQuad(q)) {
+        if (isVarSym(q.arg1)) out[n++] = q.arg1;
+        if (isVarSym(q.arg2)) out[n++] = q.arg2;
+    }
+    else if (isVarSym(q.arg1)) {
+        out[n++] = q.arg1;  // assignment source, print or sleep argument or goto condition
+    }
+    return n;
+}
+
+// Evaluate a binary quad operator the same way the executor does.
+// Returns false for operations that would trap at runtime.
+inline bool evalBinary(const SymbolInfo* op, int64_t a, int64_t b, int64_t& out) {
+    uint64_t ua = static_cast<uint64_t>(a), ub = static_cast<uint64_t>(b);
+    if (op->code == SymbolInfo::OPERATOR) {
+        switch (op->val) {
+            case SymbolInfo::PLUS: out = static_cast<int64_t>(ua + ub); return true;
+            case SymbolInfo::MINUS: out = static_cast<int64_t>(ua - ub); return true;
+            case SymbolInfo::MULTI: out = static_cast<int64_t>(ua * ub); return true;
+            case SymbolInfo::SLASH:
+            case SymbolInfo::SLASH_UNCHECKED:
+                if (b == 0 || (a == INT64_MIN && b == -1)) return false;
+                out = a / b;
+                return true;
+            case SymbolInfo::LESS: out = a < b; return true;
+            case SymbolInfo::MORE: out = a > b; return true;
+        }
+    }
+    else if (op->code == SymbolInfo::OPERATOR2) {
+        switch (op->val) {
+            case SymbolInfo::LOGICAL_EQUALS: out = a == b; return true;
+            case SymbolInfo::NOT_EQUALS: out = a != b; return true;
+            case SymbolInfo::LESS_EQUAL: out = a <= b; return true;
+            case SymbolInfo::MORE_EQUAL: out = a >= b; return true;
+            case SymbolInfo::AND: out = a && b; return true;
+            case SymbolInfo::OR: out = a || b; return true;
+        }
+    }
+    return false;
+}
+
+inline SymbolInfo* makeSym(uint8_t code, uint64_t val) {
+    SymbolInfo* s = new SymbolInfo();
+    s->code = code;
+    s->val = val;
+    return s;
+}
+
+#endif
@@ -0,0 +1,352 @@
+#include <iostream>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include "jit.h"
+#include "arrayOps.h"
+#include "symbInfo.h"
+#if defined(__x86_64__) && defined(__linux__)
+#include <sys/mman.h>
+#define JIT_X86_64
+#endif
+
+Jit::Jit(const Bytecode& bc) : bc(bc) {
+    buffer = nullptr;
+    bufferSize = 0;
+    regs = nullptr;
+    types = nullptr;
+    input = nullptr;
+    output = nullptr;
+}
+
+Jit::~Jit() {
+#ifdef JIT_X86_64
+    if (buffer != nullptr) munmap(buffer, bufferSize);
+#endif
+}
+
+bool Jit::Supported() {
+#ifdef JIT_X86_64
+    return true;
+#else
+    return false;
+#endif
+}
+
+void Jit::imm32(int32_t v) {
+    uint8_t b[4];
+    memcpy(b, &v, 4);
+    code.insert(code.end(), b, b + 4);
+}
+
+void Jit::imm64(uint64_t v) {
+    uint8_t b[8];
+    memcpy(b, &v, 8);
+    code.insert(code.end(), b, b + 8);
+}
+
+// mov reg, imm32 (sign extended) or mov reg, [rbx + slot * 8]
+void Jit::loadOperand(uint8_t reg, bool imm, int32_t field) {
+    if (imm) {
+        bytes({0x48, 0xC7, static_cast<uint8_t>(0xC0 | reg)});
+        imm32(field);
+    }
+    else {
+        bytes({0x48, 0x8B, static_cast<uint8_t>(0x83 | reg << 3)});
+        imm32(static_cast<int32_t>(static_cast<uint32_t>(field) * 8));
+    }
+}
+
+// mov [rbx + slot * 8], rax
+void Jit::storeRax(uint32_t slot) {
+    bytes({0x48, 0x89, 0x83});
+    imm32(static_cast<int32_t>(slot * 8));
+}
+
+// mov rax, fn; call rax. The three pushes in the prologue keep the stack
+// 16 byte aligned.
+void Jit::callHelper(void* fn) {
+    bytes({0x48, 0xB8});
+    imm64(reinterpret_cast<uint64_t>(fn));
+    bytes({0xFF, 0xD0});
+}
+
+// rel32 at offset at, relative to the end of the field
+void Jit::patch32(uint32_t at, uint32_t target) {
+    int32_t rel = static_cast<int32_t>(target) - static_cast<int32_t>(at + 4);
+    memcpy(&code[at], &rel, 4);
+}
+
+// cmp rax, size; jb over the error call and exit. Negative indexes are
+// out of range as unsigned numbers.
+void Jit::boundsCheck(uint32_t size, std::vector<uint32_t>& exits) {
+    bytes({0x48, 0x3D});
+    imm32(static_cast<int32_t>(size));
+    bytes({0x72, 0x14});
+    bytes({0x4C, 0x89, 0xEF});  // mov rdi, r13
+    callHelper(reinterpret_cast<void*>(&Jit::indexHelper));
+    bytes({0xE9});
+    exits.push_back(code.size());
+    imm32(0);
+}
+
+void Jit::printHelper(Jit* self, int64_t value, uint32_t op, uint32_t slot) {
+    if (op == OP_PRINT_LINE) self->output->PrintLine(value);
+    else if (op == OP_PRINT_CHAR || (op == OP_PRINT && self->types[slot] == SymbolInfo::CHAR))
+        self->output->PrintChar(value);
+    else self->output->PrintNumber(value);
+}
+
+void Jit::readHelper(Jit* self, uint32_t op, uint32_t dst) {
+    if (self->input->Interactive()) {
+        self->output->Text("Input: ");
+        self->output->BeforeWait();
+    }
+    bool asChar = op == OP_READ_CHAR || (op == OP_READ && self->types[dst] == SymbolInfo::CHAR);
+    uint8_t type = SymbolInfo::CHAR;
+    self->regs[dst] = asChar ? self->input->Char() : self->input->Token(type);
+    self->types[dst] = type;
+}
+
+void Jit::discardHelper(Jit* self) {
+    if (self->input->Interactive()) self->output->BeforeWait();
+    self->input->Skip();
+}
+
+void Jit::sleepHelper(Jit* self, int64_t ms) {
+    self->output->BeforeWait();
+    if (ms > 0) std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void Jit::yieldHelper() {
+    std::this_thread::yield();
+}
+
+void Jit::divZeroHelper(Jit* self) {
+    self->output->Text("ERROR: Division by zero!\n");
+}
+
+void Jit::indexHelper(Jit* self) {
+    self->output->Text("ERROR: Array index out of range!\n");
+}
+
+int Jit::arrayHelper(Jit* self, const Instr* in, int64_t a, int64_t b) {
+    const ArrayInfo& ar = self->bc.arrays[in->dst];
+    int64_t* r = self->regs;
+    uint8_t* types = self->types;
+    if (in->op == OP_AFILL) {
+        ArrayOps::Fill(r + ar.base, types + ar.base, ar.size, a, in->pad != 0 ? in->pad : types[in->a]);
+    }
+    else if (in->op == OP_ACOPY) {
+        const ArrayInfo& src = self->bc.arrays[a];
+        ArrayOps::Copy(r + ar.base, types + ar.base, r + src.base, types + src.base, std::min(ar.size, src.size));
+    }
+    else {
+        if (static_cast<uint64_t>(a) > ar.size || static_cast<uint64_t>(b) > ar.size - a) {
+            indexHelper(self);
+            return 0;
+        }
+        self->output->PrintRange(r + ar.base + a, types + ar.base + a, static_cast<uint32_t>(b));
+    }
+    return 1;
+}
+
+bool Jit::Compile() {
+#ifdef JIT_X86_64
+    offsets.assign(bc.code.size(), 0);
+    std::vector<std::pair<uint32_t, uint32_t>> jumps;   // rel32 field, target instruction
+    std::vector<uint32_t> exits;                        // rel32 fields jumping to the epilogue
+
+    // push rbx; push r12; push r13; rbx = regs; r12 = types; r13 = this;
+    // jmp to the entry instruction's code in rcx
+    bytes({0x53, 0x41, 0x54, 0x41, 0x55});
+    bytes({0x48, 0x89, 0xFB, 0x49, 0x89, 0xF4, 0x49, 0x89, 0xD5});
+    bytes({0xFF, 0xE1});
+
+    for (uint32_t i = 0; i < bc.code.size(); ++i) {
+        const Instr& in = bc.code[i];
+        bool immA = in.flags & IMM_A, immB = in.flags & IMM_B;
+        offsets[i] = code.size();
+        switch (in.op) {
+            case OP_MOV:
+                loadOperand(0, immA, in.a);
+                storeRax(in.dst);
+                break;
+            case OP_ADD: case OP_SUB: case OP_MUL:
+                loadOperand(0, immA, in.a);
+                loadOperand(1, immB, in.b);
+                if (in.op == OP_ADD) bytes({0x48, 0x01, 0xC8});
+                else if (in.op == OP_SUB) bytes({0x48, 0x29, 0xC8});
+                else bytes({0x48, 0x0F, 0xAF, 0xC1});
+                storeRax(in.dst);
+                break;
+            case OP_DIV: case OP_DIV_UNCHECKED:
+                loadOperand(0, immA, in.a);
+                loadOperand(1, immB, in.b);
+                if (in.op == OP_DIV) {
+                    // test rcx, rcx; jnz over the error call and exit
+                    bytes({0x48, 0x85, 0xC9, 0x75, 0x14});
+                    bytes({0x4C, 0x89, 0xEF});  // mov rdi, r13
+                    callHelper(reinterpret_cast<void*>(&Jit::divZeroHelper));
+                    bytes({0xE9});
+                    exits.push_back(code.size());
+                    imm32(0);
+                }
+                bytes({0x48, 0x99, 0x48, 0xF7, 0xF9});  // cqo; idiv rcx
+                storeRax(in.dst);
+                break;
+            case OP_LT: case OP_GT: case OP_EQ: case OP_NE: case OP_LE: case OP_GE: {
+                static const uint8_t setcc[] = { 0x9C, 0x9F, 0x94, 0x95, 0x9E, 0x9D };
+                loadOperand(0, immA, in.a);
+                loadOperand(1, immB, in.b);
+                bytes({0x48, 0x39, 0xC8, 0x0F, setcc[in.op - OP_LT], 0xC0});  // cmp rax, rcx; setcc al
+                bytes({0x0F, 0xB6, 0xC0});                                    // movzx eax, al
+                storeRax(in.dst);
+                break;
+            }
+            case OP_AND: case OP_OR:
+                loadOperand(0, immA, in.a);
+                loadOperand(1, immB, in.b);
+                // test rax, rax; setne al; test rcx, rcx; setne cl; and/or al, cl; movzx eax, al
+                bytes({0x48, 0x85, 0xC0, 0x0F, 0x95, 0xC0, 0x48, 0x85, 0xC9, 0x0F, 0x95, 0xC1});
+                bytes({static_cast<uint8_t>(in.op == OP_AND ? 0x20 : 0x08), 0xC8, 0x0F, 0xB6, 0xC0});
+                storeRax(in.dst);
+                break;
+            case OP_JMP:
+                byte(0xE9);
+                jumps.push_back({static_cast<uint32_t>(code.size()), in.dst});
+                imm32(0);
+                break;
+            case OP_JNZ:
+                loadOperand(0, immA, in.a);
+                bytes({0x48, 0x85, 0xC0, 0x0F, 0x85});  // test rax, rax; jnz
+                jumps.push_back({static_cast<uint32_t>(code.size()), in.dst});
+                imm32(0);
+                break;
+            case OP_PRINT: case OP_PRINT_NUM: case OP_PRINT_CHAR: case OP_PRINT_LINE:
+                loadOperand(0, immA, in.a);
+                bytes({0x48, 0x89, 0xC6});  // mov rsi, rax
+                bytes({0x4C, 0x89, 0xEF});  // mov rdi, r13
+                bytes({0xBA});              // mov edx, op
+                imm32(in.op);
+                bytes({0xB9});              // mov ecx, slot
+                imm32(in.a);
+                callHelper(reinterpret_cast<void*>(&Jit::printHelper));
+                break;
+            case OP_READ: case OP_READ_NUM: case OP_READ_CHAR:
+                bytes({0x4C, 0x89, 0xEF, 0xBE});  // mov rdi, r13; mov esi, op
+                imm32(in.op);
+                bytes({0xBA});                    // mov edx, dst
+                imm32(static_cast<int32_t>(in.dst));
+                callHelper(reinterpret_cast<void*>(&Jit::readHelper));
+                break;
+            case OP_READ_DISCARD:
+                bytes({0x4C, 0x89, 0xEF});  // mov rdi, r13
+                callHelper(reinterpret_cast<void*>(&Jit::discardHelper));
+                break;
+            case OP_SLEEP:
+                loadOperand(0, immA, in.a);
+                bytes({0x48, 0x89, 0xC6});  // mov rsi, rax
+                bytes({0x4C, 0x89, 0xEF});  // mov rdi, r13
+                callHelper(reinterpret_cast<void*>(&Jit::sleepHelper));
+                break;
+            case OP_YIELD:
+                callHelper(reinterpret_cast<void*>(&Jit::yieldHelper));
+                break;
+            case OP_ALOAD: {
+                const ArrayInfo& ar = bc.arrays[in.a];
+                loadOperand(0, immB, in.b);
+                boundsCheck(ar.size, exits);
+                bytes({0x48, 0x8B, 0x8C, 0xC3});        // mov rcx, [rbx + rax * 8 + base * 8]
+                imm32(static_cast<int32_t>(ar.base * 8));
+                bytes({0x41, 0x0F, 0xB6, 0x94, 0x04});  // movzx edx, byte [r12 + rax + base]
+                imm32(static_cast<int32_t>(ar.base));
+                bytes({0x48, 0x89, 0xC8});              // mov rax, rcx
+                storeRax(in.dst);
+                bytes({0x41, 0x88, 0x94, 0x24});        // mov [r12 + dst], dl
+                imm32(static_cast<int32_t>(in.dst));
+                break;
+            }
+            case OP_ASTORE: {
+                const ArrayInfo& ar = bc.arrays[in.dst];
+                loadOperand(0, immA, in.a);
+                loadOperand(1, immB, in.b);
+                boundsCheck(ar.size, exits);
+                bytes({0x48, 0x89, 0x8C, 0xC3});        // mov [rbx + rax * 8 + base * 8], rcx
+                imm32(static_cast<int32_t>(ar.base * 8));
+                if (in.pad != 0) {
+                    bytes({0x41, 0xC6, 0x84, 0x04});    // mov byte [r12 + rax + base], pad
+                    imm32(static_cast<int32_t>(ar.base));
+                    byte(static_cast<uint8_t>(in.pad));
+                }
+                else {
+                    bytes({0x41, 0x0F, 0xB6, 0x94, 0x24});  // movzx edx, byte [r12 + b]
+                    imm32(in.b);
+                    bytes({0x41, 0x88, 0x94, 0x04});        // mov [r12 + rax + base], dl
+                    imm32(static_cast<int32_t>(ar.base));
+                }
+                break;
+            }
+            case OP_AFILL: case OP_ACOPY: case OP_APRINT:
+                loadOperand(0, immA, in.a);
+                if (in.op == OP_APRINT) loadOperand(1, immB, in.b);
+                bytes({0x48, 0x89, 0xC2});  // mov rdx, rax
+                bytes({0x48, 0xBE});        // mov rsi, in
+                imm64(reinterpret_cast<uint64_t>(&in));
+                bytes({0x4C, 0x89, 0xEF});  // mov rdi, r13
+                callHelper(reinterpret_cast<void*>(&Jit::arrayHelper));
+                bytes({0x85, 0xC0, 0x0F, 0x84});  // test eax, eax; jz to the exit
+                exits.push_back(code.size());
+                imm32(0);
+                break;
+            case OP_SET_TYPE:
+                bytes({0x41, 0xC6, 0x84, 0x24});  // mov byte [r12 + dst], a
+                imm32(static_cast<int32_t>(in.dst));
+                byte(static_cast<uint8_t>(in.a));
+                break;
+            case OP_COPY_TYPE:
+                bytes({0x41, 0x0F, 0xB6, 0x84, 0x24});  // movzx eax, byte [r12 + a]
+                imm32(in.a);
+                bytes({0x41, 0x88, 0x84, 0x24});        // mov [r12 + dst], al
+                imm32(static_cast<int32_t>(in.dst));
+                break;
+            case OP_HALT:
+                byte(0xE9);
+                exits.push_back(code.size());
+                imm32(0);
+                break;
+            default:
+                return false;
+        }
+    }
+
+    // pop r13; pop r12; pop rbx; ret
+    uint32_t epilogue = code.size();
+    bytes({0x41, 0x5D, 0x41, 0x5C, 0x5B, 0xC3});
+    for (const auto& j : jumps) patch32(j.first, offsets[j.second]);
+    for (uint32_t at : exits) patch32(at, epilogue);
+
+    // Written while writable, then made executable and read-only
+    bufferSize = code.size();
+    void* mem = mmap(nullptr, bufferSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) return false;
+    memcpy(mem, code.data(), code.size());
+    if (mprotect(mem, bufferSize, PROT_READ | PROT_EXEC) != 0) {
+        munmap(mem, bufferSize);
+        return false;
+    }
+    buffer = mem;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void Jit::Run(int64_t* regs, uint8_t* types, uint32_t pc) {
+    this->regs = regs;
+    this->types = types;
+    typedef void (*Entry)(int64_t*, uint8_t*, Jit*, void*);
+    reinterpret_cast<Entry>(buffer)(regs, types, this, static_cast<uint8_t*>(buffer) + offsets[pc]);
+}
@@ -0,0 +1,61 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include <vector>
+#include "bytecode.h"
+#include "output.h"
+#include "input.h"
+
+// Translates bytecode into x86-64 machine code in an executable buffer.
+// Variables stay in the VM's register file, addressed from rbx, and the
+// type tags from r12. Array elements are loaded and stored inline with a
+// bounds check. Print, read, the bulk array operations and the runtime
+// errors are calls into runtime helpers, so their output matches the
+// interpreter.
+// On other architectures Supported() is false and Executor interprets.
+class Jit {
+public:
+    // Superinstructions are not supported, lower without fusing
+    Jit(const Bytecode& bc);
+    ~Jit();
+
+    static bool Supported();
+    bool Compile();  // False if an opcode is unsupported or no memory could be mapped
+    // Starts at instruction pc, any pc can be entered since all state is
+    // in the register file
+    void Run(int64_t* regs, uint8_t* types, uint32_t pc);
+    uint64_t CodeSize() const { return code.size(); }
+
+    Input* input;    // Where read() comes from, not owned
+    Output* output;  // Where print() goes, not owned
+private:
+    const Bytecode& bc;
+    std::vector<uint8_t> code;  // Machine code before it is copied to the buffer
+    std::vector<uint32_t> offsets;  // Instruction -> offset of its machine code
+    void* buffer;               // Executable mapping of code
+    uint64_t bufferSize;
+    int64_t* regs;              // Of the running program, for the helpers
+    uint8_t* types;
+
+    void byte(uint8_t b) { code.push_back(b); }
+    void bytes(std::initializer_list<uint8_t> bs) { code.insert(code.end(), bs); }
+    void imm32(int32_t v);
+    void imm64(uint64_t v);
+    void loadOperand(uint8_t reg, bool imm, int32_t field);  // reg 0 = rax, 1 = rcx
+    void storeRax(uint32_t slot);
+    void callHelper(void* fn);
+    void patch32(uint32_t at, uint32_t target);
+    void boundsCheck(uint32_t size, std::vector<uint32_t>& exits);  // Of the index in rax
+
+    static void printHelper(Jit* self, int64_t value, uint32_t op, uint32_t slot);
+    static void readHelper(Jit* self, uint32_t op, uint32_t dst);
+    static void discardHelper(Jit* self);
+    static void sleepHelper(Jit* self, int64_t ms);
+    static void yieldHelper();
+    static void divZeroHelper(Jit* self);
+    static void indexHelper(Jit* self);
+    // fill, copy and print of a range, false when the range is out of bounds
+    static int arrayHelper(Jit* self, const Instr* in, int64_t a, int64_t b);
+};
+
+#endif
@@ -10,30 +10,34 @@
 using std::string;
 
 
-#define SUPP_CHARS_CNT 17
-#define OP_CNT 14
+#define SUPP_CHARS_CNT 20
+#define OP_CNT 17
 #define OP2_CNT 9
 #define LOOPS_CNT 7
 #define BOOLS_CNT 3
-#define CONSOLE_CNT 2
+#define CONSOLE_CNT 4
+#define ARRAYS_CNT 3
 
-const char suppChars[SUPP_CHARS_CNT] = {'+', '-', '=', '/', '*', '!', '<', '>', '(', ')', '{', '}', ';', '.', '\'', '&', '|'};
-const char operators[OP_CNT] = {'+', '-', '=', '/', '*', '!', '<', '>', '(', ')', '{', '}', ';', '.'};
+const char suppChars[SUPP_CHARS_CNT] = {'+', '-', '=', '/', '*', '!', '<', '>', '(', ')', '{', '}', ';', '.', '[', ']', ',', '\'', '&', '|'};
+const char operators[OP_CNT] = {'+', '-', '=', '/', '*', '!', '<', '>', '(', ')', '{', '}', ';', '.', '[', ']', ','};
 const char* operators_2[OP2_CNT] = {"//", "==", "!=", "<=", ">=", "++", "--", "&&", "||"};
 
 const char* loops[LOOPS_CNT] = {"if", "else", "for", "while", "break", "continue", "return"};
 const char* bools[BOOLS_CNT] = {"true", "false", "null"};
-const char* console[CONSOLE_CNT] = {"read", "print"};
+const char* console[CONSOLE_CNT] = {"read", "print", "sleep", "yield"};
+const char* arrays[ARRAYS_CNT] = {"array", "fill", "copy"};
 
 
-Lex::Lex(){
+Lex::Lex(const std::string& path, const std::string* text) : path(path) {
     varIdx = 0;
     currLine = 1;
     fileContIdx = 0;
     error = false;
 
     st = new SymbTab();
-    ReadFile();
+    messages = &std::cout;
+    if(text != nullptr) fileContent = *text;
+    else if(ReadFile() != 0) error = true;
 }
 
 Lex::~Lex(){
@@ -114,6 +118,11 @@ SymbolInfo* Lex::RecognizeIdentifier(char ch){
             return st->addSymbol(string(buffer), SymbolInfo::CONSOLE, i);
     }
 
+    for(uint8_t i = 0; i < ARRAYS_CNT; ++i){
+        if(string(buffer) == string(arrays[i]))
+            return st->addSymbol(string(buffer), SymbolInfo::ARRAY, i);
+    }
+
     return st->addSymbol(buffer, SymbolInfo::VARIABLE, varIdx++);
 }
 
@@ -205,7 +214,7 @@ uint8_t Lex::LexicalError(char ch, const std::string &error){
     }
     else if(error != "" && ERROR){
         this->error = true;
-        std::cout << "LEX ERROR 2: " << error << " '" << ch << "'" << std::endl;
+        *messages << "LEX ERROR 2: " << error << " '" << ch << "'" << std::endl;
         return 2;
     }
     else if(ERROR){
@@ -223,9 +232,9 @@ char Lex::GetNextChar(){
 
 
 uint8_t Lex::ReadFile(){
-    std::ifstream file(INPUT_FILE); // Open file
+    std::ifstream file(path); // Open file
     if (!file) {
-        if(ERROR) std::cerr << "LEX: Unable to open file\n";
+        if(ERROR) std::cerr << "LEX: Unable to open file " << path << "\n";
         return 1;
     }
 
@@ -1,14 +1,221 @@
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cstdio>
+#include <map>
 #include "symbtab.h"
 #include "lex.h"
 #include "synt.h"
 #include "executor.h"
+#include "optimizer.h"
+#include "passManager.h"
+#include "benchmark.h"
+#include "pairProfile.h"
+#include "cBackend.h"
+#include "scheduler.h"
 #include "settings.h"
 
 // Declare the global used by the executor implementation
 extern SymbTab* GLOBAL_ST;
 
-int main() {
+// Runs the interpreter and the compiled C program on the same input and
+// reports whether they print the same. Returns the exit code for main.
+static int diffAgainstC(std::vector<Quad>& quads, const std::set<uint64_t>* taggedVars,
+                        const std::string& binPath) {
+    std::ostringstream input;
+    input << std::cin.rdbuf();
+    const std::string inPath = binPath + ".in", outPath = binPath + ".out";
+    std::ofstream(inPath) << input.str();
+
+    std::istringstream interpIn(input.str());
+    std::ostringstream interpOut;
+    std::streambuf* oldIn = std::cin.rdbuf(interpIn.rdbuf());
+    std::streambuf* oldOut = std::cout.rdbuf(interpOut.rdbuf());
+    Executor* executor = new Executor(quads);
+    if(taggedVars != nullptr)
+        executor->SetTaggedVars(*taggedVars);
+    executor->Execute();
+    delete executor;
+    std::cout.flush();
+    std::cin.rdbuf(oldIn);
+    std::cout.rdbuf(oldOut);
+    std::cin.clear();
+
+    std::string command = "./" + binPath + " < " + inPath + " > " + outPath;
+    int status = std::system(command.c_str());
+    std::ifstream nativeFile(outPath);
+    std::ostringstream nativeOut;
+    nativeOut << nativeFile.rdbuf();
+    std::remove(inPath.c_str());
+    std::remove(outPath.c_str());
+
+    const std::string expected = interpOut.str(), actual = nativeOut.str();
+    if(status == 0 && expected == actual){
+        std::cout << "C backend matches the interpreter (" << expected.size() << " bytes of output)" << std::endl;
+        return 0;
+    }
+    size_t at = 0;
+    while(at < expected.size() && at < actual.size() && expected[at] == actual[at])
+        ++at;
+    std::cout << "C backend differs from the interpreter at byte " << at << " of output";
+    if(status != 0)
+        std::cout << " (native exit status " << status << ")";
+    std::cout << std::endl;
+    return 1;
+}
+
+// Compiles every file and runs them together as green threads. A file
+// given several times is compiled once, its threads share the quads. A
+// file that does not compile is reported and left out. Returns the exit
+// code for main.
+static int runGreen(const std::vector<std::string>& files, uint8_t optLevel, bool passStats, uint32_t workers) {
+    std::vector<Lex*> lexes;
+    std::vector<Synt*> synts;
+    std::vector<Optimizer*> optimizers;
+    std::map<std::string, Synt*> compiled;  // nullptr if it does not compile
+    std::map<std::string, Optimizer*> optimized;
+    Scheduler* scheduler = new Scheduler(workers, GREEN_QUANTUM);
+    int status = 0;
+    for(const std::string& file : files){
+        if(compiled.count(file) == 0){
+            compiled[file] = nullptr;
+            optimized[file] = nullptr;
+            Lex* lex = new Lex(file);
+            Synt* synt = new Synt(lex->symbolList, lex->lines);
+            lexes.push_back(lex);
+            synts.push_back(synt);
+            SymbolInfo* si = lex->LexAnalyze();
+            while(si != nullptr){
+                lex->symbolList.push_back(*si);
+                lex->lines.push_back(lex->currLine);
+                si = lex->LexAnalyze();
+            }
+            bool parsed = !lex->error && synt->Parse();
+            GLOBAL_ST = lex->st;
+            bool verified = parsed;
+            if(parsed && optLevel > 0){
+                Optimizer* optimizer = new Optimizer(synt->quads, synt->whileLoops);
+                optimizers.push_back(optimizer);
+                optimized[file] = optimizer;
+                PassManager* passManager = new PassManager(synt->quads);
+                optimizer->AddPasses(*passManager, optLevel);
+                verified = passManager->Run();
+                if(DEBUG || passStats)
+                    passManager->PrintStats();
+                delete passManager;
+            }
+            if(verified)
+                compiled[file] = synt;
+            else if(ERROR)
+                std::cout << "ERROR: " << file << " does not compile" << std::endl;
+        }
+        Synt* synt = compiled[file];
+        Optimizer* optimizer = optimized[file];
+        if(synt == nullptr){
+            status = 1;
+            continue;
+        }
+        scheduler->Add(synt->quads, optimizer != nullptr ? &optimizer->TaggedVars() : nullptr);
+    }
+    scheduler->Run();
+    delete scheduler;
+    for(Optimizer* optimizer : optimizers)
+        delete optimizer;
+    for(Synt* synt : synts)
+        delete synt;
+    for(Lex* lex : lexes)
+        delete lex;
+    return status;
+}
+
+int main(int argc, char* argv[]) {
+    uint8_t optLevel = OPT_LEVEL;
+    bool passStats = false;
+    bool bench = false;
+    bool switchDispatch = false;
+    bool profilePairs = false;
+    bool genSuper = false;
+    bool jit = false;
+    bool tiered = false;
+    uint8_t flushPolicy = OUTPUT_FLUSH;
+    bool benchOutput = false;
+    bool batch = false;
+    std::string batchPath;
+    uint32_t workers = GREEN_WORKERS;
+    std::vector<std::string> files;  // Programs to run as green threads
+    uint8_t cMode = 0;  // 1 emits C, 2 also compiles it, 3 also diffs it against the interpreter
+    ExecutionMode execMode = RUNTIME_DEBUGGING ? EXEC_STEPPING : EXEC_FAST;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-O0" || arg == "-O1" || arg == "-O2")
+            optLevel = arg[2] - '0';
+        else if (arg == "-stats")
+            passStats = true;
+        else if (arg == "-bench")
+            bench = true;
+        else if (arg == "-switch")
+            switchDispatch = true;
+        else if (arg == "-profile-pairs")
+            profilePairs = true;
+        else if (arg == "-gen-super")
+            genSuper = true;
+        else if (arg == "-jit")
+            jit = true;
+        else if (arg == "-tiered")
+            tiered = true;
+        else if (arg.rfind("-flush=", 0) == 0 && Output::PolicyByName(arg.substr(7)) >= 0)
+            flushPolicy = Output::PolicyByName(arg.substr(7));
+        else if (arg == "-batch")
+            batch = true;
+        else if (arg.rfind("-batch=", 0) == 0 && arg.size() > 7){
+            batch = true;
+            batchPath = arg.substr(7);
+        }
+        else if (arg.rfind("-workers=", 0) == 0 && arg.size() > 9)
+            workers = static_cast<uint32_t>(std::strtoul(arg.c_str() + 9, nullptr, 10));
+        else if (!arg.empty() && arg[0] != '-')
+            files.push_back(arg);
+        else if (arg == "-bench-output")
+            benchOutput = true;
+        else if (arg == "-emit-c")
+            cMode = 1;
+        else if (arg == "-compile-c")
+            cMode = 2;
+        else if (arg == "-diff-c")
+            cMode = 3;
+        else if (arg == "-count")
+            execMode = EXEC_COUNTING;
+        else if (arg == "-trace")
+            execMode = EXEC_TRACING;
+        else if (arg == "-step")
+            execMode = EXEC_STEPPING;
+        else {
+            std::cout << "Unknown option: " << arg << std::endl;
+            std::cout << "Usage: main [-O0|-O1|-O2] [-stats] [-bench] [-switch] [-profile-pairs] [-gen-super]"
+                      << " [-count|-trace|-step] [-jit|-tiered] [-emit-c|-compile-c|-diff-c]"
+                      << " [-flush=always|newline|read|full|exit] [-bench-output]"
+                      << " [-batch[=FILE]] [-workers=N] [FILE...]" << std::endl;
+            return 1;
+        }
+    }
+
+    // Turn the accumulated pair profile into superinstructions.h, the
+    // program is not run
+    if(genSuper){
+        PairProfile* profile = new PairProfile();
+        bool written = profile->Load(PAIR_PROFILE_FILE) && profile->Generate("superinstructions.h");
+        if(written)
+            std::cout << "Wrote superinstructions.h from " << PAIR_PROFILE_FILE << std::endl;
+        else if(ERROR)
+            std::cout << "ERROR: could not write superinstructions.h" << std::endl;
+        delete profile;
+        return written ? 0 : 1;
+    }
+
+    if(!files.empty())
+        return runGreen(files, optLevel, passStats, workers);
+
     Lex* lex = new Lex();
     Synt* synt = new Synt(lex->symbolList, lex->lines);
     
@@ -38,13 +245,99 @@ int main() {
         // Set the global symbol table pointer for name lookups in executor
         GLOBAL_ST = lex->st;
 
+        // Optimize the quads
+        Optimizer* optimizer = nullptr;
+        if(optLevel > 0){
+            optimizer = new Optimizer(synt->quads, synt->whileLoops);
+            PassManager* passManager = new PassManager(synt->quads);
+            optimizer->AddPasses(*passManager, optLevel);
+            bool verified = passManager->Run();
+            if(DEBUG || passStats)
+                passManager->PrintStats();
+            if(DEBUG)
+                optimizer->PrintSummary();
+            delete passManager;
+            if(!verified){
+                delete optimizer;
+                delete synt;
+                delete lex;
+                return 1;
+            }
+        }
+
+        // Compare the quad interpreter with the bytecode VM instead of running
+        if(bench || benchOutput){
+            Benchmark* benchmark = new Benchmark(synt->quads,
+                    optimizer != nullptr ? &optimizer->TaggedVars() : nullptr);
+            if(bench)
+                benchmark->Run(5);
+            if(benchOutput)
+                benchmark->RunOutput(5);
+            delete benchmark;
+            delete optimizer;
+            delete synt;
+            delete lex;
+            return 0;
+        }
+
+        // Translate to C next to the input file, program.cmm -> program.c
+        if(cMode > 0){
+            std::string base = INPUT_FILE.substr(0, INPUT_FILE.rfind('.'));
+            const std::set<uint64_t>* tagged = optimizer != nullptr ? &optimizer->TaggedVars() : nullptr;
+            CBackend* backend = new CBackend(synt->quads, tagged);
+            int status = 0;
+            if(!backend->Write(base + ".c")){
+                if(ERROR)
+                    std::cout << "ERROR: could not write " << base << ".c" << std::endl;
+                status = 1;
+            }
+            else if(cMode >= 2 && !CBackend::Compile(base + ".c", base)){
+                if(ERROR)
+                    std::cout << "ERROR: " << C_COMPILER << " failed on " << base << ".c" << std::endl;
+                status = 1;
+            }
+            else if(cMode == 3)
+                status = diffAgainstC(synt->quads, tagged, base);
+            delete backend;
+            delete optimizer;
+            delete synt;
+            delete lex;
+            return status;
+        }
+
         // Execute the quads
         Executor* executor = new Executor(synt->quads);
+        if(optimizer != nullptr)
+            executor->SetTaggedVars(optimizer->TaggedVars());
+        if(switchDispatch)
+            executor->SetThreadedDispatch(false);
+        executor->SetMode(execMode);
+        executor->SetJit(jit);
+        executor->SetTiered(tiered);
+        executor->SetFlushPolicy(flushPolicy);
+        executor->SetBatchInput(batch, batchPath);
+        // Profile the plain instructions and add them to the profile file
+        PairProfile* profile = nullptr;
+        if(profilePairs){
+            profile = new PairProfile();
+            executor->SetSuperinstructions(false);
+            executor->SetProfile(profile);
+        }
         if(DEBUG)
             executor->PrintQuads();  // Print all generated quads
         executor->Execute();     // Execute the quads
         
+        if(profile != nullptr){
+            std::cout << std::endl;
+            if(!profile->Load(PAIR_PROFILE_FILE) || !profile->Save(PAIR_PROFILE_FILE)){
+                if(ERROR)
+                    std::cout << "ERROR: could not update " << PAIR_PROFILE_FILE << std::endl;
+            }
+            profile->PrintTop(10);
+            delete profile;
+        }
         delete executor;
+        delete optimizer;
     }
     else {
         if(ERROR)
@@ -0,0 +1,1751 @@
+#include <iostream>
+#include <algorithm>
+#include <climits>
+#include "optimizer.h"
+#include "passManager.h"
+#include "cfg.h"
+#include "ir.h"
+#include "settings.h"
+
+// Upper bounds that keep the passes close to linear on large programs
+const uint32_t MAX_AVAIL_EXPRS = 256;   // Expressions remembered per table
+const uint32_t MAX_REGION_BLOCKS = 2000; // Blocks scanned when inheriting a table
+
+Optimizer::Optimizer(std::vector<Quad>& quads, const std::vector<LoopLabels>& loops)
+        : quads(quads), loops(loops) {
+    assignOp = makeSym(SymbolInfo::OPERATOR, SymbolInfo::EQUALS);
+    tempSlots = 0;
+    nextTemp = TEMP_BASE;
+    nextLabel = LABEL_BASE;
+    for (const Quad& q : quads)
+        for (SymbolInfo* s : {q.arg1, q.arg2, q.res}) {
+            if (isTempSym(s) && s->val >= nextTemp) nextTemp = s->val + 1;
+            if (isLabelSym(s) && s->val >= nextLabel) nextLabel = s->val + 1;
+        }
+}
+
+Optimizer::~Optimizer() {
+    // Destructor
+}
+
+// Register the passes of an optimization level with the pass manager.
+// -O1 runs the cheap block-local and branch passes, -O2 adds the loop
+// passes and the analyses that need a fixpoint over the whole CFG.
+void Optimizer::AddPasses(PassManager& pm, uint8_t level) {
+    if (level == 0) return;
+    pm.AddPass("value-numbering", [this]{ return ValueNumbering(); });
+    pm.AddPass("cleanup", [this]{ return cleanup(); });
+    if (level >= 2) {
+        pm.AddPass("licm", [this]{ return LoopInvariantCodeMotion(); });
+        // Hoisted expressions may make copies left in the loops redundant
+        pm.AddPass("value-numbering", [this]{ return ValueNumbering(); });
+        pm.AddPass("cleanup", [this]{ return cleanup(); });
+        pm.AddPass("induction-variables", [this]{ return InductionVariables(); });
+        pm.AddPass("cleanup", [this]{ return cleanup(); });
+        if (LOOP_IDIOMS) {
+            pm.AddPass("loop-idioms", [this]{ return LoopIdioms(); });
+            pm.AddPass("cleanup", [this]{ return cleanup(); });
+        }
+        if (UNROLL_FACTOR > 1) {
+            pm.AddPass("unroll", [this]{ return UnrollLoops(); });
+            pm.AddPass("cleanup", [this]{ return cleanup(); });
+        }
+    }
+
+    // Loop passes rely on the labels, so branches are simplified last
+    pm.AddPass("jump-threading", [this]{
+        uint32_t threaded = 0;
+        for (uint8_t round = 0; round < 4; ++round) {
+            uint32_t changed = JumpThreading();
+            if (changed == 0) break;
+            threaded += changed + cleanup();
+        }
+        return threaded;
+    });
+    pm.AddPass("allocate-temps", [this]{ return AllocateTemps(); });
+    pm.AddPass("type-inference", [this]{ return TypeInference(); });
+    if (level >= 2)
+        pm.AddPass("value-ranges", [this]{ return ValueRanges(); });
+}
+
+// What the analyses found, for the debug output
+void Optimizer::PrintSummary() {
+    std::cout << "Optimizer: " << tempSlots << " temporary slots, " << taggedVars.size()
+              << " variables need runtime types" << std::endl;
+    uint32_t narrow = 0;
+    for (const auto& w : varWidths)
+        if (w.second <= 4) narrow++;
+    std::cout << "  " << narrow << " of " << varWidths.size()
+              << " variables fit in 32 bits" << std::endl;
+    for (const auto& tc : tripCounts)
+        std::cout << "  loop L" << (tc.first - LABEL_BASE) << ": "
+                  << tc.second << " iterations" << std::endl;
+    for (const auto& ur : unrollReport)
+        std::cout << "  unroll L" << (ur.first - LABEL_BASE) << ": " << ur.second << std::endl;
+}
+
+// The cleanup passes feed each other, run them until nothing changes
+uint32_t Optimizer::cleanup() {
+    uint32_t total = 0;
+    for (uint8_t round = 0; round < 8; ++round) {
+        uint32_t changed = Peephole() + CopyPropagation() + DeadCodeElimination();
+        removeNops();
+        total += changed;
+        if (changed == 0) break;
+    }
+    return total;
+}
+
+// Locate the while loops recorded by the parser that still have their
+// original shape and are entered only by falling into the start label.
+// Innermost loops come first.
+std::vector<Optimizer::WhileLoop> Optimizer::findLoops() {
+    std::map<uint64_t, uint32_t> labelIdx;
+    std::vector<uint32_t> gotos;
+    for (uint32_t i = 0; i < quads.size(); ++i) {
+        if (isLabelQuad(quads[i])) labelIdx[quads[i].res->val] = i;
+        else if (isGotoQuad(quads[i])) gotos.push_back(i);
+    }
+
+    std::vector<WhileLoop> found;
+    for (const LoopLabels& ll : loops) {
+        auto s = labelIdx.find(ll.startLabel->val);
+        auto e = labelIdx.find(ll.endLabel->val);
+        if (s == labelIdx.end() || e == labelIdx.end() || s->second + 1 >= e->second) continue;
+        uint32_t start = s->second, end = e->second;
+
+        const Quad& back = quads[end - 1];
+        if (!isGotoQuad(back) || back.arg1 != nullptr || !sameSym(back.res, ll.startLabel)) continue;
+
+        bool singleEntry = true;
+        for (uint32_t g : gotos) {
+            auto t = labelIdx.find(quads[g].res->val);
+            if (t == labelIdx.end()) continue;
+            bool targetInside = t->second >= start && t->second < end;
+            bool fromInside = g > start && g < end;
+            if (targetInside && !fromInside) singleEntry = false;
+        }
+        if (!singleEntry) continue;
+
+        WhileLoop loop;
+        loop.start = start;
+        loop.end = end;
+        loop.startLabel = ll.startLabel;
+        loop.endLabel = ll.endLabel;
+        found.push_back(loop);
+    }
+
+    std::sort(found.begin(), found.end(), [](const WhileLoop& a, const WhileLoop& b){
+        return a.end - a.start < b.end - b.start;
+    });
+    return found;
+}
+
+SymbolInfo* Optimizer::opSym(uint8_t code, uint64_t val) {
+    auto key = std::make_pair(code, val);
+    auto it = opCache.find(key);
+    if (it != opCache.end()) return it->second;
+    SymbolInfo* sym = makeSym(code, val);
+    opCache[key] = sym;
+    return sym;
+}
+
+SymbolInfo* Optimizer::numSym(int64_t val) {
+    return makeSym(SymbolInfo::NUMBER, static_cast<uint64_t>(val));
+}
+
+SymbolInfo* Optimizer::newTemp() {
+    return makeSym(SymbolInfo::VARIABLE, nextTemp++);
+}
+
+SymbolInfo* Optimizer::newLabel() {
+    return makeSym(SymbolInfo::VARIABLE, nextLabel++);
+}
+
+// Comparison with the opposite outcome, nullptr for && and ||
+SymbolInfo* Optimizer::invertedOp(const SymbolInfo* op) {
+    if (op->code == SymbolInfo::OPERATOR) {
+        if (op->val == SymbolInfo::LESS) return opSym(SymbolInfo::OPERATOR2, SymbolInfo::MORE_EQUAL);
+        if (op->val == SymbolInfo::MORE) return opSym(SymbolInfo::OPERATOR2, SymbolInfo::LESS_EQUAL);
+    }
+    else if (op->code == SymbolInfo::OPERATOR2) {
+        switch (op->val) {
+            case SymbolInfo::LESS_EQUAL: return opSym(SymbolInfo::OPERATOR, SymbolInfo::MORE);
+            case SymbolInfo::MORE_EQUAL: return opSym(SymbolInfo::OPERATOR, SymbolInfo::LESS);
+            case SymbolInfo::LOGICAL_EQUALS: return opSym(SymbolInfo::OPERATOR2, SymbolInfo::NOT_EQUALS);
+            case SymbolInfo::NOT_EQUALS: return opSym(SymbolInfo::OPERATOR2, SymbolInfo::LOGICAL_EQUALS);
+        }
+    }
+    return nullptr;
+}
+
+std::map<uint64_t, uint32_t> Optimizer::countUses() {
+    std::map<uint64_t, uint32_t> uses;
+    SymbolInfo* used[2];
+    for (const Quad& q : quads) {
+        uint8_t n = quadUses(q, used);
+        for (uint8_t k = 0; k < n; ++k) uses[used[k]->val]++;
+    }
+    return uses;
+}
+
+// Deleted quads are turned into NOPs by the passes and dropped here
+void Optimizer::removeNops() {
+    quads.erase(std::remove_if(quads.begin(), quads.end(),
+                               [](const Quad& q){ return isNopQuad(q); }),
+                quads.end());
+}
+
+Optimizer::Operand Optimizer::canonical(const AvailTable& table, SymbolInfo* sym) {
+    if (sym == nullptr) return Operand(0, 0);
+    if (isConstSym(sym)) return Operand(1, sym->val);
+    auto it = table.copies.find(sym->val);
+    if (it != table.copies.end()) return it->second;
+    return Operand(2, sym->val);
+}
+
+// Forget everything that depends on the old value of var
+void Optimizer::killVar(AvailTable& table, uint64_t var) {
+    Operand v(2, var);
+    for (auto it = table.exprs.begin(); it != table.exprs.end(); ) {
+        if (it->second->val == var || std::get<2>(it->first) == v || std::get<3>(it->first) == v)
+            it = table.exprs.erase(it);
+        else ++it;
+    }
+    table.copies.erase(var);
+    for (auto it = table.copies.begin(); it != table.copies.end(); ) {
+        if (it->second == v) it = table.copies.erase(it);
+        else ++it;
+    }
+}
+
+// Variables that may be redefined between the end of idom(block) and the
+// start of block: everything defined in blocks that reach block without
+// passing through its immediate dominator.
+std::set<uint64_t> Optimizer::regionDefs(const CFG& cfg, uint32_t block,
+                                         const std::vector<std::set<uint64_t>>& blockDefs,
+                                         bool& overflow) {
+    std::set<uint64_t> defs;
+    uint32_t stop = cfg.idom[block];
+    overflow = false;
+
+    std::vector<uint32_t> work;
+    std::set<uint32_t> seen;
+    for (uint32_t p : cfg.blocks[block].preds)
+        if (p != stop && cfg.Reachable(p) && seen.insert(p).second) work.push_back(p);
+    while (!work.empty()) {
+        uint32_t b = work.back();
+        work.pop_back();
+        if (seen.size() > MAX_REGION_BLOCKS) {
+            overflow = true;
+            return defs;
+        }
+        defs.insert(blockDefs[b].begin(), blockDefs[b].end());
+        for (uint32_t p : cfg.blocks[b].preds)
+            if (p != stop && cfg.Reachable(p) && seen.insert(p).second) work.push_back(p);
+    }
+    return defs;
+}
+
+// Value numbering over the dominator tree. Within a block, copies are
+// tracked so that "x = a; x + b" matches "a + b". A block inherits the
+// expressions available at the end of its immediate dominator, minus those
+// whose operands or holders may be redefined on the way.
+// A redundant computation becomes a copy from the variable holding the value.
+uint32_t Optimizer::ValueNumbering() {
+    CFG cfg(quads);
+    uint32_t n = cfg.blocks.size();
+    if (n == 0) return 0;
+
+    std::vector<std::set<uint64_t>> blockDefs(n);
+    for (uint32_t b = 0; b < n; ++b)
+        for (uint32_t i = cfg.blocks[b].first; i < cfg.blocks[b].last; ++i)
+            if (SymbolInfo* d = quadDef(quads[i])) blockDefs[b].insert(d->val);
+
+    // End-of-block tables, released once all dominator tree children are done
+    std::vector<AvailTable*> outTables(n, nullptr);
+    std::vector<uint32_t> pendingChildren(n, 0);
+    for (uint32_t b = 0; b < n; ++b)
+        pendingChildren[b] = cfg.domChildren[b].size();
+
+    uint32_t replaced = 0;
+    for (uint32_t b : cfg.rpo) {
+        AvailTable* table = new AvailTable();
+        if (b != 0) {
+            uint32_t parent = cfg.idom[b];
+            bool overflow = false;
+            std::set<uint64_t> killed = regionDefs(cfg, b, blockDefs, overflow);
+            if (!overflow) {
+                *table = *outTables[parent];
+                for (uint64_t v : killed) killVar(*table, v);
+            }
+            if (--pendingChildren[parent] == 0) {
+                delete outTables[parent];
+                outTables[parent] = nullptr;
+            }
+        }
+
+        for (uint32_t i = cfg.blocks[b].first; i < cfg.blocks[b].last; ++i) {
+            Quad& q = quads[i];
+            SymbolInfo* def = quadDef(q);
+            if (def == nullptr) continue;
+
+            if (isBinaryQuad(q)) {
+                Operand a = canonical(*table, q.arg1);
+                Operand c = canonical(*table, q.arg2);
+                if (isCommutativeQuad(q) && c < a) std::swap(a, c);
+                if (a.first == 1 && c.first == 1) {
+                    // Constant expressions are left for Peephole to fold
+                    killVar(*table, def->val);
+                    continue;
+                }
+                ExprKey key(q.op->code, q.op->val, a, c);
+
+                auto it = table->exprs.find(key);
+                if (it != table->exprs.end()) {
+                    SymbolInfo* holder = it->second;
+                    replaced++;
+                    if (holder->val == def->val) {
+                        // The destination already holds this value
+                        q.op = nullptr;
+                        q.arg1 = q.arg2 = q.res = nullptr;
+                        continue;
+                    }
+                    q.op = assignOp;
+                    q.arg1 = holder;
+                    q.arg2 = nullptr;
+                    killVar(*table, def->val);
+                    table->copies[def->val] = Operand(2, holder->val);
+                    continue;
+                }
+
+                killVar(*table, def->val);
+                Operand self(2, def->val);
+                if (a != self && c != self && table->exprs.size() < MAX_AVAIL_EXPRS)
+                    table->exprs[key] = def;
+            }
+            else {
+                // Assignment or read
+                Operand src = isAssignQuad(q) ? canonical(*table, q.arg1) : Operand(0, 0);
+                killVar(*table, def->val);
+                if (src.first != 0 && src != Operand(2, def->val))
+                    table->copies[def->val] = src;
+            }
+        }
+
+        if (pendingChildren[b] > 0) outTables[b] = table;
+        else delete table;
+    }
+
+    for (AvailTable* t : outTables) delete t;
+    return replaced;
+}
+
+// Forward copy propagation inside each block. A temporary that is copied
+// into a variable right after being computed is computed into the variable
+// instead ("t = e; x = t" becomes "x = e; t = x"), which leaves the
+// temporary dead once its other uses have been propagated.
+uint32_t Optimizer::CopyPropagation() {
+    CFG cfg(quads);
+    uint32_t changed = 0;
+
+    for (const BasicBlock& bb : cfg.blocks) {
+        std::map<uint64_t, SymbolInfo*> copyOf;  // Variable -> symbol it currently equals
+        auto lookup = [&copyOf](SymbolInfo* sym) -> SymbolInfo* {
+            if (!isVarSym(sym)) return nullptr;
+            auto it = copyOf.find(sym->val);
+            return it != copyOf.end() ? it->second : nullptr;
+        };
+
+        for (uint32_t i = bb.first; i < bb.last; ++i) {
+            Quad& q = quads[i];
+            if (q.op == nullptr) continue;
+
+            SymbolInfo* repl;
+            if (isBinaryQuad(q)) {
+                if ((repl = lookup(q.arg1)) != nullptr) { q.arg1 = repl; changed++; }
+                if ((repl = lookup(q.arg2)) != nullptr) { q.arg2 = repl; changed++; }
+            }
+            else if (isAssignQuad(q) || isCondGotoQuad(q) || isWaitQuad(q)) {
+                if ((repl = lookup(q.arg1)) != nullptr) { q.arg1 = repl; changed++; }
+            }
+            else if (isArrayQuad(q)) {
+                if ((repl = lookup(q.arg1)) != nullptr) { q.arg1 = repl; changed++; }
+                if ((repl = lookup(q.arg2)) != nullptr) { q.arg2 = repl; changed++; }
+            }
+            else if (isPrintQuad(q)) {
+                // A number literal prints differently from a number variable
+                repl = lookup(q.arg1);
+                if (repl != nullptr && repl->code != SymbolInfo::NUMBER) { q.arg1 = repl; changed++; }
+            }
+
+            SymbolInfo* def = quadDef(q);
+            if (def == nullptr) continue;
+
+            if (isTempSym(def) && !isReadQuad(q) && i + 1 < bb.last) {
+                Quad& next = quads[i + 1];
+                if (isAssignQuad(next) && sameSym(next.arg1, def) && isVarSym(next.res) &&
+                        !sameSym(next.res, def)) {
+                    q.res = next.res;
+                    next.arg1 = q.res;
+                    next.res = def;
+                    def = q.res;
+                    changed++;
+                }
+            }
+
+            copyOf.erase(def->val);
+            for (auto it = copyOf.begin(); it != copyOf.end(); ) {
+                if (sameSym(it->second, def)) it = copyOf.erase(it);
+                else ++it;
+            }
+            if (isAssignQuad(q) && !sameSym(q.arg1, def))
+                copyOf[def->val] = q.arg1;
+        }
+    }
+    return changed;
+}
+
+// Local rewrites:
+//   x = x                      -> removed
+//   t = 2 + 3                  -> t = 5
+//   GOTO <constant>            -> removed or unconditional
+//   t = v + 1; v = v + 1       -> v = v + 1; t = v   (postfix ++/-- in expressions)
+//   c = a < b; t = c == 0      -> t = a >= b          (if/while conditions)
+uint32_t Optimizer::Peephole() {
+    CFG cfg(quads);
+    std::map<uint64_t, uint32_t> uses = countUses();
+    uint32_t changed = 0;
+
+    for (const BasicBlock& bb : cfg.blocks) {
+        std::map<uint64_t, uint32_t> lastDef;  // Variable -> index of its latest def in the block
+        for (uint32_t i = bb.first; i < bb.last; ++i) {
+            Quad& q = quads[i];
+            if (q.op == nullptr) continue;
+
+            if (isAssignQuad(q) && sameSym(q.arg1, q.res)) {
+                q.op = nullptr;
+                q.arg1 = q.arg2 = q.res = nullptr;
+                changed++;
+                continue;
+            }
+
+            if (isCondGotoQuad(q) && isConstSym(q.arg1)) {
+                if (q.arg1->val == 0) {
+                    q.op = nullptr;
+                    q.res = nullptr;
+                }
+                q.arg1 = nullptr;
+                changed++;
+                continue;
+            }
+
+            if (isBinaryQuad(q) && isConstSym(q.arg1) && isConstSym(q.arg2)) {
+                int64_t value;
+                if (evalBinary(q.op, static_cast<int64_t>(q.arg1->val),
+                               static_cast<int64_t>(q.arg2->val), value)) {
+                    q.op = assignOp;
+                    q.arg1 = numSym(value);
+                    q.arg2 = nullptr;
+                    changed++;
+                }
+            }
+
+            if (isBinaryQuad(q) && isTempSym(q.res) && isVarSym(q.arg1) && i + 1 < bb.last) {
+                Quad& next = quads[i + 1];
+                if (isBinaryQuad(next) && next.op->code == q.op->code && next.op->val == q.op->val &&
+                        sameSym(next.arg1, q.arg1) && sameSym(next.arg2, q.arg2) &&
+                        sameSym(next.res, q.arg1) && !sameSym(q.arg2, q.arg1)) {
+                    std::swap(q.res, next.res);
+                    next.op = assignOp;
+                    next.arg1 = q.res;
+                    next.arg2 = nullptr;
+                    changed++;
+                }
+            }
+
+            // Test of a comparison result against zero
+            if (isOp(q, SymbolInfo::OPERATOR2, SymbolInfo::LOGICAL_EQUALS) ||
+                    isOp(q, SymbolInfo::OPERATOR2, SymbolInfo::NOT_EQUALS)) {
+                SymbolInfo* cond = nullptr;
+                if (isTempSym(q.arg1) && isConstSym(q.arg2) && q.arg2->val == 0) cond = q.arg1;
+                else if (isTempSym(q.arg2) && isConstSym(q.arg1) && q.arg1->val == 0) cond = q.arg2;
+
+                auto defIt = cond != nullptr ? lastDef.find(cond->val) : lastDef.end();
+                if (defIt != lastDef.end() && uses[cond->val] == 1) {
+                    Quad& cmp = quads[defIt->second];
+                    bool stable = true;
+                    for (SymbolInfo* arg : {cmp.arg1, cmp.arg2}) {
+                        auto it = isVarSym(arg) ? lastDef.find(arg->val) : lastDef.end();
+                        if (it != lastDef.end() && it->second > defIt->second) stable = false;
+                    }
+
+                    // The comparison already yields 0/1, so "!= 0" keeps it as is
+                    SymbolInfo* newOp = nullptr;
+                    if (stable && isBoolQuad(cmp))
+                        newOp = isOp(q, SymbolInfo::OPERATOR2, SymbolInfo::LOGICAL_EQUALS) ?
+                                invertedOp(cmp.op) : cmp.op;
+
+                    if (newOp != nullptr) {
+                        q.op = newOp;
+                        q.arg1 = cmp.arg1;
+                        q.arg2 = cmp.arg2;
+                        cmp.op = nullptr;
+                        cmp.arg1 = cmp.arg2 = cmp.res = nullptr;
+                        lastDef.erase(cond->val);
+                        changed++;
+                    }
+                }
+            }
+
+            if (SymbolInfo* def = quadDef(q)) lastDef[def->val] = i;
+        }
+    }
+    return changed;
+}
+
+// Remove computations into temporaries that are never read.
+// Divisions stay unless the divisor is a non-zero constant, they may trap,
+// and so do array loads.
+uint32_t Optimizer::DeadCodeElimination() {
+    uint32_t removed = 0;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        std::map<uint64_t, uint32_t> uses = countUses();
+        for (Quad& q : quads) {
+            SymbolInfo* def = quadDef(q);
+            if (!isTempSym(def) || uses[def->val] != 0) continue;
+            if (isReadQuad(q) || isArrayQuad(q)) continue;  // Loads check their index
+            if (isOp(q, SymbolInfo::OPERATOR, SymbolInfo::SLASH) &&
+                    (!isConstSym(q.arg2) || q.arg2->val == 0))
+                continue;
+            q.op = nullptr;
+            q.arg1 = q.arg2 = q.res = nullptr;
+            removed++;
+            changed = true;
+        }
+    }
+    return removed;
+}
+
+// Move loop-invariant computations into temporaries in front of the loop's
+// start label, which is only reached by falling through from above.
+// Loops are handled innermost first so invariants can move several levels.
+uint32_t Optimizer::LoopInvariantCodeMotion() {
+    uint32_t hoisted = 0;
+    std::set<uint64_t> done;
+    while (true) {
+        std::vector<WhileLoop> found = findLoops();
+        auto it = std::find_if(found.begin(), found.end(), [&done](const WhileLoop& l){
+            return done.count(l.startLabel->val) == 0;
+        });
+        if (it == found.end()) break;
+        done.insert(it->startLabel->val);
+        hoisted += hoistInvariants(*it);
+    }
+    return hoisted;
+}
+
+uint32_t Optimizer::hoistInvariants(const WhileLoop& loop) {
+    CFG cfg(quads);
+    SymbolInfo* used[2];
+
+    std::map<uint64_t, uint32_t> defCount;
+    std::map<uint64_t, std::vector<uint32_t>> usesInLoop;
+    std::set<uint64_t> usedOutside;
+    for (uint32_t i = 0; i < quads.size(); ++i) {
+        bool inside = i > loop.start && i < loop.end;
+        SymbolInfo* def = quadDef(quads[i]);
+        if (inside && def != nullptr) defCount[def->val]++;
+        uint8_t n = quadUses(quads[i], used);
+        for (uint8_t k = 0; k < n; ++k) {
+            if (inside) usesInLoop[used[k]->val].push_back(i);
+            else usedOutside.insert(used[k]->val);
+        }
+    }
+
+    // The condition code up to the exit test runs whenever the loop is entered
+    uint32_t headerEnd = loop.start + 1;
+    while (headerEnd < loop.end && !isGotoQuad(quads[headerEnd])) headerEnd++;
+
+    std::vector<bool> hoist(quads.size(), false);
+    std::set<uint64_t> invariantVars;
+    auto invariant = [&](SymbolInfo* sym) {
+        return !isVarSym(sym) || defCount[sym->val] == 0 || invariantVars.count(sym->val) > 0;
+    };
+
+    uint32_t count = 0;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (uint32_t i = loop.start + 1; i < loop.end; ++i) {
+            const Quad& q = quads[i];
+            if (hoist[i] || !(isBinaryQuad(q) || isAssignQuad(q))) continue;
+            if (!isTempSym(q.res) || defCount[q.res->val] != 1) continue;
+            if (!invariant(q.arg1) || !invariant(q.arg2)) continue;
+
+            bool alwaysRuns = i < headerEnd;
+            if (usedOutside.count(q.res->val) > 0 && !alwaysRuns) continue;
+            // Never make a division that could trap run speculatively
+            if (isOp(q, SymbolInfo::OPERATOR, SymbolInfo::SLASH) && !alwaysRuns) {
+                int64_t d = isConstSym(q.arg2) ? static_cast<int64_t>(q.arg2->val) : 0;
+                if (d == 0 || d == -1) continue;
+            }
+
+            // Every use inside the loop must see this definition
+            bool dominatesUses = true;
+            uint32_t defBlock = cfg.BlockOf(i);
+            for (uint32_t u : usesInLoop[q.res->val]) {
+                uint32_t useBlock = cfg.BlockOf(u);
+                if (useBlock == defBlock ? u <= i : !cfg.Dominates(defBlock, useBlock))
+                    dominatesUses = false;
+            }
+            if (!dominatesUses) continue;
+
+            hoist[i] = true;
+            invariantVars.insert(q.res->val);
+            count++;
+            changed = true;
+        }
+    }
+    if (count == 0) return 0;
+
+    std::vector<Quad> result;
+    result.reserve(quads.size());
+    result.insert(result.end(), quads.begin(), quads.begin() + loop.start);
+    for (uint32_t i = loop.start + 1; i < loop.end; ++i)
+        if (hoist[i]) result.push_back(quads[i]);
+    for (uint32_t i = loop.start; i < quads.size(); ++i)
+        if (!hoist[i]) result.push_back(quads[i]);
+    quads.swap(result);
+    return count;
+}
+
+std::vector<Optimizer::InductionVar> Optimizer::basicInductionVars(const WhileLoop& loop) {
+    std::map<uint64_t, uint32_t> defCount, defIdx;
+    for (uint32_t i = loop.start + 1; i < loop.end; ++i) {
+        if (SymbolInfo* def = quadDef(quads[i])) {
+            defCount[def->val]++;
+            defIdx[def->val] = i;
+        }
+    }
+
+    std::vector<InductionVar> ivs;
+    for (const auto& dc : defCount) {
+        if (dc.second != 1) continue;
+        const Quad& q = quads[defIdx[dc.first]];
+        bool plus = isOp(q, SymbolInfo::OPERATOR, SymbolInfo::PLUS);
+        bool minus = isOp(q, SymbolInfo::OPERATOR, SymbolInfo::MINUS);
+        SymbolInfo* stepSym = nullptr;
+        if ((plus || minus) && sameSym(q.arg1, q.res) && isConstSym(q.arg2)) stepSym = q.arg2;
+        else if (plus && sameSym(q.arg2, q.res) && isConstSym(q.arg1)) stepSym = q.arg1;
+        if (stepSym == nullptr || stepSym->val == 0) continue;
+
+        InductionVar iv;
+        iv.var = q.res;
+        iv.update = defIdx[dc.first];
+        iv.step = static_cast<int64_t>(stepSym->val);
+        if (minus) iv.step = -iv.step;
+        ivs.push_back(iv);
+    }
+    return ivs;
+}
+
+// Relational operator with its operands swapped (a < b is b > a)
+static void mirrorRelop(uint8_t& code, uint64_t& op) {
+    if (code == SymbolInfo::OPERATOR)
+        op = op == SymbolInfo::LESS ? SymbolInfo::MORE : SymbolInfo::LESS;
+    else if (op == SymbolInfo::LESS_EQUAL) op = SymbolInfo::MORE_EQUAL;
+    else if (op == SymbolInfo::MORE_EQUAL) op = SymbolInfo::LESS_EQUAL;
+}
+
+// Index of the quad computing the loop's exit condition, the comparison
+// right before the first conditional goto to the end label, or UINT32_MAX
+uint32_t Optimizer::exitTest(const WhileLoop& loop) {
+    uint32_t g = loop.start + 1;
+    while (g < loop.end && !isGotoQuad(quads[g])) g++;
+    if (g >= loop.end || g < loop.start + 2 || !isCondGotoQuad(quads[g]) ||
+            !sameSym(quads[g].res, loop.endLabel))
+        return UINT32_MAX;
+    const Quad& test = quads[g - 1];
+    if (!isBinaryQuad(test) || !sameSym(test.res, quads[g].arg1)) return UINT32_MAX;
+    return g - 1;
+}
+
+// Number of times the body of a counted loop runs: the loop must leave only
+// through its header test "iv relop constant", update the induction variable
+// on every iteration and start it from a constant set right before the loop.
+bool Optimizer::tripCount(const WhileLoop& loop, const std::vector<InductionVar>& ivs, int64_t& trips) {
+    uint32_t test = exitTest(loop);
+    if (test == UINT32_MAX) return false;
+
+    for (uint32_t i = loop.start + 1; i < loop.end - 1; ++i) {
+        if (!isGotoQuad(quads[i]) || i == test + 1) continue;
+        if (sameSym(quads[i].res, loop.startLabel) || sameSym(quads[i].res, loop.endLabel))
+            return false;  // continue or break
+        for (const LoopLabels& ll : loops)
+            if (sameSym(quads[i].res, ll.endLabel) || sameSym(quads[i].res, ll.startLabel)) {
+                // Jumps to inner loop labels stay inside, anything else leaves
+                bool inner = false;
+                for (uint32_t k = loop.start + 1; k < loop.end; ++k)
+                    if (isLabelQuad(quads[k]) && sameSym(quads[k].res, quads[i].res)) inner = true;
+                if (!inner) return false;
+            }
+    }
+
+    const Quad& cmp = quads[test];
+    const InductionVar* iv = nullptr;
+    bool swapped = false;
+    for (const InductionVar& cand : ivs) {
+        if (sameSym(cmp.arg1, cand.var) && isConstSym(cmp.arg2)) iv = &cand;
+        else if (sameSym(cmp.arg2, cand.var) && isConstSym(cmp.arg1)) { iv = &cand; swapped = true; }
+    }
+    if (iv == nullptr) return false;
+    int64_t bound = static_cast<int64_t>((swapped ? cmp.arg1 : cmp.arg2)->val);
+
+    CFG cfg(quads);
+    if (!cfg.Dominates(cfg.BlockOf(iv->update), cfg.BlockOf(loop.end - 1))) return false;
+
+    // Initial value from the same block, right in front of the loop
+    bool found = false;
+    int64_t init = 0;
+    for (uint32_t i = loop.start; i-- > 0; ) {
+        if (isLabelQuad(quads[i]) || isGotoQuad(quads[i])) break;
+        if (sameSym(quadDef(quads[i]), iv->var)) {
+            if (isAssignQuad(quads[i]) && isConstSym(quads[i].arg1)) {
+                init = static_cast<int64_t>(quads[i].arg1->val);
+                found = true;
+            }
+            break;
+        }
+    }
+    if (!found) return false;
+
+    // Exit condition with the induction variable on the left
+    uint8_t code = cmp.op->code;
+    uint64_t op = cmp.op->val;
+    if (swapped) mirrorRelop(code, op);
+
+    // Keep the arithmetic well away from overflow
+    const int64_t LIMIT = INT64_C(1) << 40;
+    int64_t step = iv->step;
+    if (init < -LIMIT || init > LIMIT || bound < -LIMIT || bound > LIMIT ||
+            step < -LIMIT || step > LIMIT)
+        return false;
+
+    int64_t dist = bound - init;
+    if (code == SymbolInfo::OPERATOR2 && op == SymbolInfo::MORE_EQUAL && step > 0)
+        trips = dist <= 0 ? 0 : (dist + step - 1) / step;
+    else if (code == SymbolInfo::OPERATOR && op == SymbolInfo::MORE && step > 0)
+        trips = dist < 0 ? 0 : dist / step + 1;
+    else if (code == SymbolInfo::OPERATOR2 && op == SymbolInfo::LESS_EQUAL && step < 0)
+        trips = dist >= 0 ? 0 : (-dist - step - 1) / -step;
+    else if (code == SymbolInfo::OPERATOR && op == SymbolInfo::LESS && step < 0)
+        trips = dist > 0 ? 0 : -dist / -step + 1;
+    else if (code == SymbolInfo::OPERATOR2 && op == SymbolInfo::LOGICAL_EQUALS) {
+        if (dist % step != 0 || dist / step < 0) return false;
+        trips = dist / step;
+    }
+    else if (code == SymbolInfo::OPERATOR2 && op == SymbolInfo::NOT_EQUALS)
+        trips = dist != 0 ? 0 : 1;
+    else return false;
+    return true;
+}
+
+// Replace "t = iv * c" by a temporary s that is kept equal to iv * c with
+// an addition next to the induction variable's update. When the induction
+// variable is then only needed for the exit test, the test is rewritten in
+// terms of s and the original variable's update is dropped.
+uint32_t Optimizer::reduceStrength(const WhileLoop& loop, const std::vector<InductionVar>& ivs) {
+    std::map<uint64_t, uint32_t> defCount;
+    for (uint32_t i = loop.start + 1; i < loop.end; ++i)
+        if (SymbolInfo* def = quadDef(quads[i])) defCount[def->val]++;
+
+    struct Reduced {
+        const InductionVar* iv;
+        SymbolInfo* factor;   // Constant or loop-invariant variable
+        SymbolInfo* temp;     // Holds iv * factor
+    };
+    std::vector<Reduced> reduced;
+    std::vector<std::pair<uint32_t, Quad>> inserts;  // Insert quad before index
+
+    for (uint32_t i = loop.start + 1; i < loop.end; ++i) {
+        Quad& q = quads[i];
+        if (!isOp(q, SymbolInfo::OPERATOR, SymbolInfo::MULTI) || !isVarSym(q.res)) continue;
+
+        const InductionVar* iv = nullptr;
+        SymbolInfo* factor = nullptr;
+        for (const InductionVar& cand : ivs) {
+            if (sameSym(q.arg1, cand.var)) { iv = &cand; factor = q.arg2; }
+            else if (sameSym(q.arg2, cand.var)) { iv = &cand; factor = q.arg1; }
+            if (iv != nullptr) break;
+        }
+        if (iv == nullptr || sameSym(q.res, iv->var)) continue;
+        if (isVarSym(factor) && (defCount[factor->val] > 0 || sameSym(factor, iv->var))) continue;
+
+        Reduced* r = nullptr;
+        for (Reduced& cand : reduced)
+            if (cand.iv == iv && sameSym(cand.factor, factor)) r = &cand;
+        if (r == nullptr) {
+            Reduced fresh;
+            fresh.iv = iv;
+            fresh.factor = factor;
+            fresh.temp = newTemp();
+            reduced.push_back(fresh);
+            r = &reduced.back();
+
+            SymbolInfo* step;
+            if (isConstSym(factor)) {
+                step = numSym(static_cast<int64_t>(factor->val * static_cast<uint64_t>(iv->step)));
+            }
+            else {
+                step = newTemp();
+                inserts.push_back({loop.start, {opSym(SymbolInfo::OPERATOR, SymbolInfo::MULTI),
+                                                factor, numSym(iv->step), step}});
+            }
+            inserts.push_back({loop.start, {opSym(SymbolInfo::OPERATOR, SymbolInfo::MULTI),
+                                            iv->var, factor, r->temp}});
+            inserts.push_back({iv->update + 1, {opSym(SymbolInfo::OPERATOR, SymbolInfo::PLUS),
+                                                r->temp, step, r->temp}});
+        }
+
+        q.op = assignOp;
+        q.arg1 = r->temp;
+        q.arg2 = nullptr;
+    }
+    if (reduced.empty()) return 0;
+
+    // Linear function test replacement
+    uint32_t test = exitTest(loop);
+    for (const Reduced& r : reduced) {
+        if (test == UINT32_MAX || !isConstSym(r.factor)) break;
+        int64_t factor = static_cast<int64_t>(r.factor->val);
+        Quad& cmp = quads[test];
+        SymbolInfo* bound = sameSym(cmp.arg1, r.iv->var) ? cmp.arg2 : cmp.arg1;
+        if (factor <= 0 || factor > (INT64_C(1) << 20) || !isConstSym(bound)) continue;
+        int64_t b = static_cast<int64_t>(bound->val);
+        if (b < -(INT64_C(1) << 40) || b > (INT64_C(1) << 40)) continue;
+        if (!isBinaryQuad(cmp) || isOp(cmp, SymbolInfo::OPERATOR2, SymbolInfo::AND) ||
+                isOp(cmp, SymbolInfo::OPERATOR2, SymbolInfo::OR))
+            continue;
+
+        // The variable must not be needed anywhere else
+        SymbolInfo* used[2];
+        uint32_t otherUses = 0;
+        for (uint32_t i = 0; i < quads.size(); ++i) {
+            if (i == test || i == r.iv->update) continue;
+            uint8_t n = quadUses(quads[i], used);
+            for (uint8_t k = 0; k < n; ++k)
+                if (sameSym(used[k], r.iv->var)) otherUses++;
+        }
+        if (otherUses > 0) continue;
+
+        if (sameSym(cmp.arg1, r.iv->var)) {
+            cmp.arg1 = r.temp;
+            cmp.arg2 = numSym(b * factor);
+        }
+        else {
+            cmp.arg2 = r.temp;
+            cmp.arg1 = numSym(b * factor);
+        }
+        Quad& update = quads[r.iv->update];
+        update.op = nullptr;
+        update.arg1 = update.arg2 = update.res = nullptr;
+        break;
+    }
+
+    std::stable_sort(inserts.begin(), inserts.end(),
+                     [](const std::pair<uint32_t, Quad>& a, const std::pair<uint32_t, Quad>& b){
+                         return a.first > b.first;
+                     });
+    for (uint32_t k = 0; k < inserts.size(); ) {
+        uint32_t pos = inserts[k].first;
+        std::vector<Quad> group;
+        for (; k < inserts.size() && inserts[k].first == pos; ++k) group.push_back(inserts[k].second);
+        quads.insert(quads.begin() + pos, group.begin(), group.end());
+    }
+    return reduced.size();
+}
+
+// Induction variable analysis for every recognised while loop: record trip
+// counts of counted loops and strength-reduce multiplications by basic
+// induction variables.
+uint32_t Optimizer::InductionVariables() {
+    uint32_t count = 0;
+    std::set<uint64_t> done;
+    while (true) {
+        std::vector<WhileLoop> found = findLoops();
+        auto it = std::find_if(found.begin(), found.end(), [&done](const WhileLoop& l){
+            return done.count(l.startLabel->val) == 0;
+        });
+        if (it == found.end()) break;
+        done.insert(it->startLabel->val);
+
+        std::vector<InductionVar> ivs = basicInductionVars(*it);
+        if (ivs.empty()) continue;
+        int64_t trips;
+        if (tripCount(*it, ivs, trips)) tripCounts[it->startLabel->val] = trips;
+        count += reduceStrength(*it, ivs);
+    }
+    return count;
+}
+
+// Replace loops whose only effect is counting, such as
+//   wait = 5000; while (wait >= 0) wait--;
+// by the final values of their induction variables. The loop must consist
+// of nothing but its exit test and induction variable updates.
+uint32_t Optimizer::LoopIdioms() {
+    uint32_t count = 0;
+    std::set<uint64_t> done;
+    while (true) {
+        std::vector<WhileLoop> found = findLoops();
+        auto it = std::find_if(found.begin(), found.end(), [&done](const WhileLoop& l){
+            return done.count(l.startLabel->val) == 0;
+        });
+        if (it == found.end()) break;
+        done.insert(it->startLabel->val);
+        if (replaceCountingLoop(*it)) count++;
+    }
+    return count;
+}
+
+bool Optimizer::replaceCountingLoop(const WhileLoop& loop) {
+    uint32_t test = exitTest(loop);
+    if (test != loop.start + 1) return false;
+    std::vector<InductionVar> ivs = basicInductionVars(loop);
+    if (ivs.empty()) return false;
+
+    // Body: induction variable updates only
+    for (uint32_t i = test + 2; i < loop.end - 1; ++i) {
+        bool isUpdate = false;
+        for (const InductionVar& iv : ivs)
+            if (iv.update == i) isUpdate = true;
+        if (!isUpdate) return false;
+    }
+    if (test + 2 + ivs.size() != loop.end - 1) return false;
+
+    const Quad& cmp = quads[test];
+    const InductionVar* iv = nullptr;
+    bool swapped = false;
+    for (const InductionVar& cand : ivs) {
+        if (sameSym(cmp.arg1, cand.var)) iv = &cand;
+        else if (sameSym(cmp.arg2, cand.var)) { iv = &cand; swapped = true; }
+    }
+    if (iv == nullptr) return false;
+    SymbolInfo* bound = swapped ? cmp.arg1 : cmp.arg2;
+    for (const InductionVar& other : ivs)
+        if (sameSym(bound, other.var)) return false;
+
+    SymbolInfo* plusOp = opSym(SymbolInfo::OPERATOR, SymbolInfo::PLUS);
+    SymbolInfo* minusOp = opSym(SymbolInfo::OPERATOR, SymbolInfo::MINUS);
+    SymbolInfo* multiOp = opSym(SymbolInfo::OPERATOR, SymbolInfo::MULTI);
+    std::vector<Quad> closed;
+
+    int64_t trips;
+    if (tripCount(loop, ivs, trips)) {
+        // Everything is known, no test needed
+        for (const InductionVar& v : ivs) {
+            int64_t delta = static_cast<int64_t>(static_cast<uint64_t>(trips) * static_cast<uint64_t>(v.step));
+            if (delta != 0) closed.push_back({plusOp, v.var, numSym(delta), v.var});
+        }
+    }
+    else {
+        // Unit steps only: the iteration count is the distance to the bound
+        uint8_t code = cmp.op->code;
+        uint64_t op = cmp.op->val;
+        if (swapped) mirrorRelop(code, op);
+        bool up = iv->step == 1, down = iv->step == -1;
+        bool inclusive;
+        if (up && code == SymbolInfo::OPERATOR2 && op == SymbolInfo::MORE_EQUAL) inclusive = false;
+        else if (up && code == SymbolInfo::OPERATOR && op == SymbolInfo::MORE) inclusive = true;
+        else if (down && code == SymbolInfo::OPERATOR2 && op == SymbolInfo::LESS_EQUAL) inclusive = false;
+        else if (down && code == SymbolInfo::OPERATOR && op == SymbolInfo::LESS) inclusive = true;
+        else return false;
+
+        // The header test stays and skips everything when the body never runs
+        closed.push_back(quads[test]);
+        closed.push_back(quads[test + 1]);
+        SymbolInfo* tc = newTemp();
+        if (up) closed.push_back({minusOp, bound, iv->var, tc});
+        else closed.push_back({minusOp, iv->var, bound, tc});
+        if (inclusive) closed.push_back({plusOp, tc, numSym(1), tc});
+        for (const InductionVar& v : ivs) {
+            if (v.step == 1) closed.push_back({plusOp, v.var, tc, v.var});
+            else if (v.step == -1) closed.push_back({minusOp, v.var, tc, v.var});
+            else {
+                SymbolInfo* delta = newTemp();
+                closed.push_back({multiOp, tc, numSym(v.step), delta});
+                closed.push_back({plusOp, v.var, delta, v.var});
+            }
+        }
+    }
+
+    // Keep both labels, drop the test, body and back edge
+    quads.erase(quads.begin() + loop.start + 1, quads.begin() + loop.end);
+    quads.insert(quads.begin() + loop.start + 1, closed.begin(), closed.end());
+    return true;
+}
+
+// Unroll counted while loops, whose exit test compares a basic induction
+// variable moving towards a loop-invariant bound:
+//   LABEL start; t = iv >= bound; GOTO t end; body; GOTO start; LABEL end
+// becomes
+//   b2 = bound - (U-1)*step
+//   LABEL start; t2 = iv >= b2; GOTO t2 rem; body x U; GOTO start
+//   LABEL rem; t = iv >= bound; GOTO t end; body; GOTO rem; LABEL end
+// The unrolled loop runs while at least U iterations remain and the
+// remainder loop finishes the rest. Bodies may branch, but only to their
+// own labels, which every copy renames. UNROLL_MAX_QUADS limits the size
+// of the unrolled body by lowering the factor.
+uint32_t Optimizer::UnrollLoops() {
+    uint32_t count = 0;
+    std::set<uint64_t> done;
+    unrollReport.clear();
+    while (true) {
+        std::vector<WhileLoop> found = findLoops();
+        auto it = std::find_if(found.begin(), found.end(), [&done](const WhileLoop& l){
+            return done.count(l.startLabel->val) == 0;
+        });
+        if (it == found.end()) break;
+        done.insert(it->startLabel->val);
+
+        bool unrolled = false;
+        std::string decision = unrollLoop(*it, unrolled);
+        unrollReport.push_back({it->startLabel->val, decision});
+        if (unrolled) count++;
+    }
+    return count;
+}
+
+// Returns the decision for the debug dump
+std::string Optimizer::unrollLoop(const WhileLoop& loop, bool& unrolled) {
+    unrolled = false;
+    uint32_t test = exitTest(loop);
+    if (test != loop.start + 1) return "no exit test at the top";
+    std::vector<InductionVar> ivs = basicInductionVars(loop);
+    const Quad cmp = quads[test];
+    const InductionVar* iv = nullptr;
+    bool swapped = false;
+    for (const InductionVar& cand : ivs) {
+        if (sameSym(cmp.arg1, cand.var)) iv = &cand;
+        else if (sameSym(cmp.arg2, cand.var)) { iv = &cand; swapped = true; }
+    }
+    if (iv == nullptr) return "no induction variable in the exit test";
+
+    SymbolInfo* bound = swapped ? cmp.arg1 : cmp.arg2;
+    if (!isConstSym(bound) && !isVarSym(bound)) return "no bound";
+    for (uint32_t i = loop.start + 1; i < loop.end; ++i)
+        if (sameSym(quadDef(quads[i]), bound)) return "bound changes in the loop";
+
+    uint8_t code = cmp.op->code;
+    uint64_t op = cmp.op->val;
+    if (swapped) mirrorRelop(code, op);
+    bool up = (code == SymbolInfo::OPERATOR2 && op == SymbolInfo::MORE_EQUAL) ||
+              (code == SymbolInfo::OPERATOR && op == SymbolInfo::MORE);
+    bool down = (code == SymbolInfo::OPERATOR2 && op == SymbolInfo::LESS_EQUAL) ||
+                (code == SymbolInfo::OPERATOR && op == SymbolInfo::LESS);
+    if (!(up && iv->step > 0) && !(down && iv->step < 0))
+        return "induction variable does not move towards the bound";
+
+    // Body: everything between the exit goto and the back edge
+    uint32_t first = test + 2, last = loop.end - 1;
+    if (first >= last) return "empty body";
+    std::set<uint64_t> bodyLabels;
+    for (uint32_t i = first; i < last; ++i)
+        if (isLabelQuad(quads[i])) bodyLabels.insert(quads[i].res->val);
+    for (uint32_t i = first; i < last; ++i)
+        if (isGotoQuad(quads[i]) && bodyLabels.count(quads[i].res->val) == 0)
+            return "body jumps out of the loop";
+    CFG cfg(quads);
+    if (!cfg.Dominates(cfg.BlockOf(iv->update), cfg.BlockOf(loop.end - 1)))
+        return "induction variable is not updated on every iteration";
+
+    uint32_t size = last - first;
+    uint32_t factor = UNROLL_FACTOR;
+    while (factor > 1 && factor * size > UNROLL_MAX_QUADS) factor--;
+    if (factor < 2) return "body of " + std::to_string(size) + " quads is too large";
+    auto tc = tripCounts.find(loop.startLabel->val);
+    if (tc != tripCounts.end() && tc->second < factor)
+        return "only " + std::to_string(tc->second) + " iterations";
+    if (nextLabel + (factor + 1) * bodyLabels.size() >= TEMP_BASE) return "out of labels";
+
+    int64_t delta;
+    if (__builtin_mul_overflow(static_cast<int64_t>(factor - 1), iv->step, &delta))
+        return "step too large";
+
+    // Temporaries local to one iteration, written before being read and
+    // not used outside the body. Every copy gets its own.
+    std::map<uint64_t, bool> local;
+    for (uint32_t i = first; i < last; ++i) {
+        SymbolInfo* uses[2];
+        uint8_t n = quadUses(quads[i], uses);
+        for (uint8_t k = 0; k < n; ++k)
+            if (isTempSym(uses[k])) local.insert({uses[k]->val, false});
+        SymbolInfo* def = quadDef(quads[i]);
+        if (isTempSym(def)) local.insert({def->val, true});
+    }
+    for (uint32_t i = 0; i < quads.size(); ++i) {
+        if (i == first) i = last;
+        for (SymbolInfo* s : {quads[i].arg1, quads[i].arg2, quads[i].res})
+            if (isTempSym(s) && local.count(s->val) > 0) local[s->val] = false;
+    }
+    auto copyBody = [&](std::vector<Quad>& out) {
+        std::map<uint64_t, SymbolInfo*> rename;
+        for (const auto& l : local)
+            if (l.second) rename[l.first] = newTemp();
+        for (uint64_t l : bodyLabels) rename[l] = newLabel();
+        for (uint32_t i = first; i < last; ++i) {
+            Quad q = quads[i];
+            for (SymbolInfo** s : {&q.arg1, &q.arg2, &q.res}) {
+                if (!isTempSym(*s) && !isLabelSym(*s)) continue;
+                auto r = rename.find((*s)->val);
+                if (r != rename.end()) *s = r->second;
+            }
+            out.push_back(q);
+        }
+    };
+
+    // Bound of the unrolled loop's test, the guard skips to the remainder
+    // loop when computing it would wrap around
+    SymbolInfo* rem = newLabel();
+    SymbolInfo* gotoOp = quads[test + 1].op;
+    std::vector<Quad> result;
+    SymbolInfo* bound2;
+    if (isConstSym(bound)) {
+        int64_t b2;
+        if (__builtin_sub_overflow(static_cast<int64_t>(bound->val), delta, &b2))
+            return "bound too close to the integer limits";
+        bound2 = numSym(b2);
+    }
+    else {
+        SymbolInfo* wraps = newTemp();
+        if (delta > 0)
+            result.push_back({opSym(SymbolInfo::OPERATOR, SymbolInfo::LESS), bound,
+                              numSym(INT64_MIN + delta), wraps});
+        else
+            result.push_back({opSym(SymbolInfo::OPERATOR, SymbolInfo::MORE), bound,
+                              numSym(INT64_MAX + delta), wraps});
+        result.push_back({gotoOp, wraps, nullptr, rem});
+        bound2 = newTemp();
+        result.push_back({opSym(SymbolInfo::OPERATOR, SymbolInfo::MINUS), bound,
+                          numSym(delta), bound2});
+    }
+
+    result.push_back(quads[loop.start]);
+    SymbolInfo* exit2 = newTemp();
+    result.push_back({cmp.op, swapped ? bound2 : cmp.arg1, swapped ? cmp.arg2 : bound2, exit2});
+    result.push_back({gotoOp, exit2, nullptr, rem});
+    for (uint32_t i = first; i < last; ++i) result.push_back(quads[i]);
+    for (uint32_t k = 1; k < factor; ++k) copyBody(result);
+    result.push_back(quads[loop.end - 1]);
+
+    result.push_back({nullptr, nullptr, nullptr, rem});
+    result.push_back(cmp);
+    result.push_back(quads[test + 1]);
+    copyBody(result);
+    result.push_back({gotoOp, nullptr, nullptr, rem});
+
+    quads.erase(quads.begin() + loop.start, quads.begin() + loop.end);
+    quads.insert(quads.begin() + loop.start, result.begin(), result.end());
+    unrolled = true;
+    return std::to_string(factor) + "x, body " + std::to_string(size) + " quads";
+}
+
+// Branch simplification:
+//   - gotos to a label followed by an unconditional goto jump to its target
+//   - "GOTO t L1; GOTO L2; L1:" becomes a single inverted conditional goto
+//   - gotos to the next instruction and unreachable quads are removed
+//   - labels no goto refers to are removed, merging their blocks
+uint32_t Optimizer::JumpThreading() {
+    uint32_t changed = 0;
+    std::map<uint64_t, uint32_t> labelIdx;
+    for (uint32_t i = 0; i < quads.size(); ++i)
+        if (isLabelQuad(quads[i])) labelIdx[quads[i].res->val] = i;
+
+    // First quad after a run of labels
+    auto skipLabels = [this](uint32_t i) {
+        while (i < quads.size() && (isLabelQuad(quads[i]) || isNopQuad(quads[i]))) i++;
+        return i;
+    };
+    // True if label sits in the run of labels starting at i
+    auto inLabelRun = [&](uint32_t i, const SymbolInfo* label) {
+        auto it = labelIdx.find(label->val);
+        return it != labelIdx.end() && it->second >= i && skipLabels(i) > it->second;
+    };
+
+    // Thread every goto to its final destination
+    for (Quad& q : quads) {
+        if (!isGotoQuad(q)) continue;
+        SymbolInfo* target = q.res;
+        for (uint8_t hops = 0; hops < 32; ++hops) {
+            auto it = labelIdx.find(target->val);
+            if (it == labelIdx.end()) break;
+            uint32_t next = skipLabels(it->second);
+            if (next >= quads.size() || !isGotoQuad(quads[next]) || quads[next].arg1 != nullptr ||
+                    sameSym(quads[next].res, target))
+                break;
+            target = quads[next].res;
+        }
+        if (!sameSym(target, q.res)) {
+            q.res = target;
+            changed++;
+        }
+    }
+
+    std::map<uint64_t, uint32_t> uses = countUses();
+    for (uint32_t i = 0; i < quads.size(); ++i) {
+        Quad& q = quads[i];
+        if (!isGotoQuad(q)) continue;
+
+        if (inLabelRun(i + 1, q.res)) {
+            // Jump to the next instruction; a dead condition is cleaned up later
+            q.op = nullptr;
+            q.arg1 = q.res = nullptr;
+            changed++;
+            continue;
+        }
+
+        if (q.arg1 != nullptr && i + 1 < quads.size()) {
+            Quad& over = quads[i + 1];
+            if (!isGotoQuad(over) || over.arg1 != nullptr || !inLabelRun(i + 2, q.res)) continue;
+
+            // Branch over a branch: jump to the second target when the condition fails
+            Quad* cmp = i > 0 ? &quads[i - 1] : nullptr;
+            SymbolInfo* inverted = nullptr;
+            if (cmp != nullptr && isBoolQuad(*cmp) && sameSym(cmp->res, q.arg1) &&
+                    isTempSym(q.arg1) && uses[q.arg1->val] == 1)
+                inverted = invertedOp(cmp->op);
+
+            if (inverted != nullptr) {
+                cmp->op = inverted;
+                q.res = over.res;
+                over.op = nullptr;
+                over.res = nullptr;
+            }
+            else {
+                SymbolInfo* cond = q.arg1;
+                SymbolInfo* notCond = newTemp();
+                q.op = opSym(SymbolInfo::OPERATOR2, SymbolInfo::LOGICAL_EQUALS);
+                q.arg1 = cond;
+                q.arg2 = numSym(0);
+                q.res = notCond;
+                over.arg1 = notCond;
+            }
+            changed++;
+        }
+    }
+
+    // Unreachable code after unconditional gotos
+    for (uint32_t i = 0; i + 1 < quads.size(); ++i) {
+        if (!isGotoQuad(quads[i]) || quads[i].arg1 != nullptr) continue;
+        for (uint32_t k = i + 1; k < quads.size() && !isLabelQuad(quads[k]); ++k) {
+            if (isNopQuad(quads[k])) continue;
+            quads[k].op = nullptr;
+            quads[k].arg1 = quads[k].arg2 = quads[k].res = nullptr;
+            changed++;
+        }
+    }
+
+    std::set<uint64_t> referenced;
+    for (const Quad& q : quads)
+        if (isGotoQuad(q)) referenced.insert(q.res->val);
+    for (Quad& q : quads) {
+        if (isLabelQuad(q) && referenced.count(q.res->val) == 0) {
+            q.res = nullptr;
+            changed++;
+        }
+    }
+
+    removeNops();
+    return changed;
+}
+
+// Map temporaries onto a small set of reusable slots. Liveness is computed
+// per block, each temporary gets the interval of quad indices where it may
+// be live, and a linear scan hands out slots so that overlapping intervals
+// never share one. Returns the number of temporaries renamed.
+// Must run last: afterwards temporaries are no longer defined only once.
+uint32_t Optimizer::AllocateTemps() {
+    std::map<uint64_t, uint32_t> tempIdx;
+    for (const Quad& q : quads)
+        for (SymbolInfo* s : {q.arg1, q.arg2, q.res})
+            if (isTempSym(s) && tempIdx.count(s->val) == 0) {
+                uint32_t idx = tempIdx.size();
+                tempIdx[s->val] = idx;
+            }
+    uint32_t nt = tempIdx.size();
+    if (nt == 0) return 0;
+
+    CFG cfg(quads);
+    uint32_t nb = cfg.blocks.size();
+    std::vector<std::set<uint32_t>> use(nb), def(nb), liveIn(nb), liveOut(nb);
+    SymbolInfo* used[2];
+    for (uint32_t b = 0; b < nb; ++b) {
+        for (uint32_t i = cfg.blocks[b].first; i < cfg.blocks[b].last; ++i) {
+            uint8_t n = quadUses(quads[i], used);
+            for (uint8_t k = 0; k < n; ++k)
+                if (isTempSym(used[k]) && def[b].count(tempIdx[used[k]->val]) == 0)
+                    use[b].insert(tempIdx[used[k]->val]);
+            SymbolInfo* d = quadDef(quads[i]);
+            if (isTempSym(d)) def[b].insert(tempIdx[d->val]);
+        }
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (uint32_t b = nb; b-- > 0; ) {
+            std::set<uint32_t> out;
+            for (uint32_t s : cfg.blocks[b].succs) out.insert(liveIn[s].begin(), liveIn[s].end());
+            std::set<uint32_t> in = use[b];
+            for (uint32_t t : out)
+                if (def[b].count(t) == 0) in.insert(t);
+            if (in != liveIn[b] || out != liveOut[b]) {
+                liveIn[b].swap(in);
+                liveOut[b].swap(out);
+                changed = true;
+            }
+        }
+    }
+
+    // Live intervals over quad indices
+    std::vector<uint32_t> start(nt, UINT32_MAX), end(nt, 0);
+    auto extend = [&](uint32_t t, uint32_t i) {
+        start[t] = std::min(start[t], i);
+        end[t] = std::max(end[t], i);
+    };
+    for (uint32_t b = 0; b < nb; ++b) {
+        for (uint32_t t : liveIn[b]) extend(t, cfg.blocks[b].first);
+        for (uint32_t t : liveOut[b]) extend(t, cfg.blocks[b].last - 1);
+        for (uint32_t i = cfg.blocks[b].first; i < cfg.blocks[b].last; ++i)
+            for (SymbolInfo* s : {quads[i].arg1, quads[i].arg2, quads[i].res})
+                if (isTempSym(s)) extend(tempIdx[s->val], i);
+    }
+
+    std::vector<uint32_t> order(nt);
+    for (uint32_t t = 0; t < nt; ++t) order[t] = t;
+    std::sort(order.begin(), order.end(), [&start](uint32_t a, uint32_t b){ return start[a] < start[b]; });
+
+    std::vector<uint32_t> slot(nt);
+    std::vector<uint32_t> freeSlots;
+    std::multimap<uint32_t, uint32_t> active;  // Interval end -> temporary
+    uint32_t slotCount = 0;
+    for (uint32_t t : order) {
+        while (!active.empty() && active.begin()->first < start[t]) {
+            freeSlots.push_back(slot[active.begin()->second]);
+            active.erase(active.begin());
+        }
+        if (freeSlots.empty()) {
+            slot[t] = slotCount++;
+        }
+        else {
+            slot[t] = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        active.insert({end[t], t});
+    }
+
+    std::vector<SymbolInfo*> slotSyms(slotCount);
+    for (uint32_t k = 0; k < slotCount; ++k)
+        slotSyms[k] = makeSym(SymbolInfo::VARIABLE, TEMP_BASE + k);
+    for (Quad& q : quads)
+        for (SymbolInfo** s : {&q.arg1, &q.arg2, &q.res})
+            if (isTempSym(*s)) *s = slotSyms[slot[tempIdx[(*s)->val]]];
+
+    tempSlots = slotCount;
+    nextTemp = TEMP_BASE + slotCount;
+    return nt;
+}
+
+// Static types of the variables at every point, so print() and read() know
+// up front whether a value is a number or a char. A variable that was never
+// assigned behaves like a number in the executor. read() without a known
+// char destination parses a token, so its result is only known at runtime.
+// Prints and reads of such ambiguous variables stay generic, and those
+// variables (plus everything copied into them) keep runtime type tags.
+uint32_t Optimizer::TypeInference() {
+    CFG cfg(quads);
+    uint32_t nb = cfg.blocks.size();
+    taggedVars.clear();
+    if (nb == 0) return 0;
+
+    std::vector<TypeState> in(nb), out(nb);
+    std::vector<bool> visited(nb, false);
+    auto join = [](TypeState& into, const TypeState& from) {
+        for (auto& entry : into)
+            if (typeOf(from, entry.first) != entry.second) entry.second = TYPE_DYNAMIC;
+        for (const auto& entry : from)
+            if (into.count(entry.first) == 0 && entry.second != TYPE_NUMBER)
+                into[entry.first] = TYPE_DYNAMIC;
+    };
+
+    std::set<uint32_t> work;
+    for (uint32_t b : cfg.rpo) work.insert(b);
+    while (!work.empty()) {
+        uint32_t b = *work.begin();
+        work.erase(work.begin());
+
+        TypeState state;
+        bool first = true;
+        for (uint32_t p : cfg.blocks[b].preds) {
+            if (!visited[p]) continue;
+            if (first) state = out[p];
+            else join(state, out[p]);
+            first = false;
+        }
+        in[b] = state;
+        for (uint32_t i = cfg.blocks[b].first; i < cfg.blocks[b].last; ++i)
+            applyType(state, quads[i]);
+
+        if (!visited[b] || state != out[b]) {
+            visited[b] = true;
+            out[b].swap(state);
+            for (uint32_t s : cfg.blocks[b].succs) work.insert(s);
+        }
+    }
+
+    uint32_t typed = 0;
+    for (uint32_t b = 0; b < nb; ++b) {
+        TypeState state = in[b];
+        for (uint32_t i = cfg.blocks[b].first; i < cfg.blocks[b].last; ++i) {
+            Quad& q = quads[i];
+            if (isOp(q, SymbolInfo::CONSOLE, SymbolInfo::PRINT) && isVarSym(q.arg1)) {
+                uint8_t t = typeOf(state, q.arg1->val);
+                if (t == TYPE_NUMBER) q.op = opSym(SymbolInfo::CONSOLE, SymbolInfo::PRINT_NUMBER);
+                else if (t == TYPE_CHAR) q.op = opSym(SymbolInfo::CONSOLE, SymbolInfo::PRINT_CHAR);
+                else taggedVars.insert(q.arg1->val);
+                if (t != TYPE_DYNAMIC) typed++;
+            }
+            else if (isOp(q, SymbolInfo::CONSOLE, SymbolInfo::READ) && isVarSym(q.res)) {
+                uint8_t t = typeOf(state, q.res->val);
+                if (t == TYPE_NUMBER) q.op = opSym(SymbolInfo::CONSOLE, SymbolInfo::READ_NUMBER);
+                else if (t == TYPE_CHAR) q.op = opSym(SymbolInfo::CONSOLE, SymbolInfo::READ_CHAR);
+                else taggedVars.insert(q.res->val);
+                if (t != TYPE_DYNAMIC) typed++;
+            }
+            else if ((isOp(q, SymbolInfo::ARRAY, SymbolInfo::STORE) ||
+                      isOp(q, SymbolInfo::ARRAY, SymbolInfo::FILL)) && isVarSym(q.arg1)) {
+                // Elements take the type of the value stored in them
+                bool store = q.op->val == SymbolInfo::STORE;
+                uint8_t t = typeOf(state, q.arg1->val);
+                if (t == TYPE_NUMBER)
+                    q.op = opSym(SymbolInfo::ARRAY, store ? SymbolInfo::STORE_NUMBER : SymbolInfo::FILL_NUMBER);
+                else if (t == TYPE_CHAR)
+                    q.op = opSym(SymbolInfo::ARRAY, store ? SymbolInfo::STORE_CHAR : SymbolInfo::FILL_CHAR);
+                else taggedVars.insert(q.arg1->val);
+                if (t != TYPE_DYNAMIC) typed++;
+            }
+            applyType(state, q);
+        }
+    }
+
+    // A tagged variable copies its tag from the variables assigned to it
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (const Quad& q : quads)
+            if (isAssignQuad(q) && isVarSym(q.arg1) && taggedVars.count(q.res->val) > 0 &&
+                    taggedVars.insert(q.arg1->val).second)
+                changed = true;
+    }
+    return typed;
+}
+
+uint8_t Optimizer::typeOf(const TypeState& state, uint64_t var) {
+    auto it = state.find(var);
+    return it != state.end() ? it->second : TYPE_NUMBER;
+}
+
+void Optimizer::applyType(TypeState& state, const Quad& q) {
+    SymbolInfo* def = quadDef(q);
+    if (def == nullptr) return;
+    uint8_t t = TYPE_NUMBER;
+    if (isAssignQuad(q)) {
+        if (q.arg1->code == SymbolInfo::CHAR) t = TYPE_CHAR;
+        else if (isVarSym(q.arg1)) t = typeOf(state, q.arg1->val);
+    }
+    else if (isOp(q, SymbolInfo::CONSOLE, SymbolInfo::READ_CHAR)) {
+        t = TYPE_CHAR;
+    }
+    else if (isReadQuad(q)) {
+        t = typeOf(state, def->val) == TYPE_CHAR ? TYPE_CHAR : TYPE_DYNAMIC;
+    }
+    else if (isOp(q, SymbolInfo::ARRAY, SymbolInfo::LOAD)) {
+        t = TYPE_DYNAMIC;  // Elements keep the type of what was stored
+    }
+    if (t == TYPE_NUMBER) state.erase(def->val);
+    else state[def->val] = t;
+}
+
+// Interval analysis over the CFG. Conditional gotos narrow the ranges of
+// the compared variables on each outgoing edge, loop headers widen ranges
+// that keep growing to the full range, and a few descending passes win
+// back the loop bounds. Divisions whose divisor range excludes 0 (and
+// cannot overflow) become SLASH_UNCHECKED. The range at every definition
+// also gives each variable's storage width, see VarWidths().
+// Must run last: the rewritten divisions are only safe where they are.
+uint32_t Optimizer::ValueRanges() {
+    CFG cfg(quads);
+    uint32_t nb = cfg.blocks.size();
+    varWidths.clear();
+    if (nb == 0) return 0;
+
+    std::vector<uint32_t> order(nb, UINT32_MAX);  // Position in reverse postorder
+    for (uint32_t k = 0; k < cfg.rpo.size(); ++k) order[cfg.rpo[k]] = k;
+    std::vector<bool> loopHead(nb, false);
+    for (uint32_t b : cfg.rpo)
+        for (uint32_t p : cfg.blocks[b].preds)
+            if (order[p] != UINT32_MAX && order[p] >= order[b]) loopHead[b] = true;
+
+    std::vector<RangeState> in(nb), out(nb);
+    std::vector<bool> visited(nb, false);
+    std::vector<uint32_t> visits(nb, 0);
+
+    // Join of the states flowing into b, false if no edge into b can be taken
+    auto inState = [&](uint32_t b, RangeState& state) {
+        state.clear();
+        bool reached = b == 0;  // The entry starts with unknown values
+        for (uint32_t p : cfg.blocks[b].preds) {
+            if (!visited[p]) continue;
+            RangeState edge = out[p];
+            const BasicBlock& pb = cfg.blocks[p];
+            if (isCondGotoQuad(quads[pb.last - 1]) && pb.succs.size() == 2 &&
+                    !refineBranch(pb, b == pb.succs[0], edge))
+                continue;
+            if (!reached) {
+                state.swap(edge);
+                reached = true;
+                continue;
+            }
+            for (auto it = state.begin(); it != state.end(); ) {
+                auto e = edge.find(it->first);
+                if (e == edge.end()) {
+                    it = state.erase(it);
+                    continue;
+                }
+                it->second.lo = std::min(it->second.lo, e->second.lo);
+                it->second.hi = std::max(it->second.hi, e->second.hi);
+                ++it;
+            }
+        }
+        return reached;
+    };
+    auto transfer = [&](uint32_t b, RangeState& state) {
+        for (uint32_t i = cfg.blocks[b].first; i < cfg.blocks[b].last; ++i)
+            applyRange(state, quads[i]);
+    };
+
+    std::set<uint32_t> work;
+    for (uint32_t k = 0; k < cfg.rpo.size(); ++k) work.insert(k);
+    while (!work.empty()) {
+        uint32_t b = cfg.rpo[*work.begin()];
+        work.erase(work.begin());
+
+        RangeState state;
+        if (!inState(b, state)) continue;
+        if (loopHead[b] && visits[b] >= 2) {
+            for (auto it = state.begin(); it != state.end(); ) {
+                auto prev = in[b].find(it->first);
+                if (prev == in[b].end()) {
+                    it = state.erase(it);
+                    continue;
+                }
+                it->second.lo = it->second.lo < prev->second.lo ? INT64_MIN : prev->second.lo;
+                it->second.hi = it->second.hi > prev->second.hi ? INT64_MAX : prev->second.hi;
+                ++it;
+            }
+        }
+        visits[b]++;
+        in[b] = state;
+        transfer(b, state);
+
+        if (!visited[b] || state != out[b]) {
+            visited[b] = true;
+            out[b].swap(state);
+            for (uint32_t s : cfg.blocks[b].succs) work.insert(order[s]);
+        }
+    }
+
+    // Descending passes, every result still covers all reachable values
+    for (uint8_t round = 0; round < 2; ++round) {
+        for (uint32_t b : cfg.rpo) {
+            RangeState state;
+            if (!visited[b] || !inState(b, state)) continue;
+            in[b] = state;
+            transfer(b, state);
+            out[b].swap(state);
+        }
+    }
+
+    uint32_t unchecked = 0;
+    for (uint32_t b = 0; b < nb; ++b) {
+        if (!visited[b]) continue;
+        RangeState state = in[b];
+        for (uint32_t i = cfg.blocks[b].first; i < cfg.blocks[b].last; ++i) {
+            Quad& q = quads[i];
+            if (isOp(q, SymbolInfo::OPERATOR, SymbolInfo::SLASH) &&
+                    divisionSafe(rangeOf(state, q.arg1), rangeOf(state, q.arg2))) {
+                q.op = opSym(SymbolInfo::OPERATOR, SymbolInfo::SLASH_UNCHECKED);
+                unchecked++;
+            }
+            SymbolInfo* def = quadDef(q);
+            if (def != nullptr) {
+                Range r = evalRange(q, state);
+                uint8_t width = 8;
+                if (r.lo >= INT8_MIN && r.hi <= INT8_MAX) width = 1;
+                else if (r.lo >= INT16_MIN && r.hi <= INT16_MAX) width = 2;
+                else if (r.lo >= INT32_MIN && r.hi <= INT32_MAX) width = 4;
+                uint8_t& w = varWidths[def->val];
+                w = std::max(w, width);
+            }
+            applyRange(state, q);
+        }
+    }
+    return unchecked;
+}
+
+Optimizer::Range Optimizer::rangeOf(const RangeState& state, const SymbolInfo* sym) {
+    if (isConstSym(sym)) {
+        int64_t v = static_cast<int64_t>(sym->val);
+        return {v, v};
+    }
+    if (isVarSym(sym)) {
+        auto it = state.find(sym->val);
+        if (it != state.end()) return it->second;
+    }
+    return {INT64_MIN, INT64_MAX};
+}
+
+// Range of the value a quad writes. Results that could wrap around are
+// treated as unknown.
+Optimizer::Range Optimizer::evalRange(const Quad& q, const RangeState& state) {
+    Range full = {INT64_MIN, INT64_MAX};
+    if (isAssignQuad(q)) return rangeOf(state, q.arg1);
+    if (isOp(q, SymbolInfo::CONSOLE, SymbolInfo::READ_CHAR)) return {CHAR_MIN, CHAR_MAX};
+    if (isBoolQuad(q)) return {0, 1};
+    if (!isBinaryQuad(q)) return full;
+
+    Range a = rangeOf(state, q.arg1), b = rangeOf(state, q.arg2);
+    int64_t c[4];
+    bool overflow = false;
+    switch (q.op->val) {
+        case SymbolInfo::PLUS:
+            overflow = __builtin_add_overflow(a.lo, b.lo, &c[0]) |
+                       __builtin_add_overflow(a.hi, b.hi, &c[1]);
+            return overflow ? full : Range{c[0], c[1]};
+        case SymbolInfo::MINUS:
+            overflow = __builtin_sub_overflow(a.lo, b.hi, &c[0]) |
+                       __builtin_sub_overflow(a.hi, b.lo, &c[1]);
+            return overflow ? full : Range{c[0], c[1]};
+        case SymbolInfo::MULTI:
+            overflow = __builtin_mul_overflow(a.lo, b.lo, &c[0]) |
+                       __builtin_mul_overflow(a.lo, b.hi, &c[1]) |
+                       __builtin_mul_overflow(a.hi, b.lo, &c[2]) |
+                       __builtin_mul_overflow(a.hi, b.hi, &c[3]);
+            break;
+        case SymbolInfo::SLASH:
+        case SymbolInfo::SLASH_UNCHECKED:
+            // With the divisor's sign fixed the quotient is monotonic in
+            // each operand, so the extremes are at the corners
+            if (!divisionSafe(a, b)) return full;
+            c[0] = a.lo / b.lo;
+            c[1] = a.lo / b.hi;
+            c[2] = a.hi / b.lo;
+            c[3] = a.hi / b.hi;
+            break;
+        default:
+            return full;
+    }
+    if (overflow) return full;
+    return {*std::min_element(c, c + 4), *std::max_element(c, c + 4)};
+}
+
+void Optimizer::applyRange(RangeState& state, const Quad& q) {
+    SymbolInfo* def = quadDef(q);
+    if (def == nullptr) return;
+    Range r = evalRange(q, state);
+    if (r.lo == INT64_MIN && r.hi == INT64_MAX) state.erase(def->val);
+    else state[def->val] = r;
+}
+
+// Narrow x to the values for which "x op y" can hold for some value of y.
+// Returns false if there are none.
+bool Optimizer::narrowRange(Range& x, uint8_t code, uint64_t op, const Range& y) {
+    if (code == SymbolInfo::OPERATOR && op == SymbolInfo::LESS) {
+        if (y.hi == INT64_MIN) return false;
+        x.hi = std::min(x.hi, y.hi - 1);
+    }
+    else if (code == SymbolInfo::OPERATOR && op == SymbolInfo::MORE) {
+        if (y.lo == INT64_MAX) return false;
+        x.lo = std::max(x.lo, y.lo + 1);
+    }
+    else if (code == SymbolInfo::OPERATOR2 && op == SymbolInfo::LESS_EQUAL) {
+        x.hi = std::min(x.hi, y.hi);
+    }
+    else if (code == SymbolInfo::OPERATOR2 && op == SymbolInfo::MORE_EQUAL) {
+        x.lo = std::max(x.lo, y.lo);
+    }
+    else if (code == SymbolInfo::OPERATOR2 && op == SymbolInfo::LOGICAL_EQUALS) {
+        x.lo = std::max(x.lo, y.lo);
+        x.hi = std::min(x.hi, y.hi);
+    }
+    else if (code == SymbolInfo::OPERATOR2 && op == SymbolInfo::NOT_EQUALS && y.lo == y.hi) {
+        if (x.lo == x.hi) return x.lo != y.lo;
+        if (x.lo == y.lo) x.lo++;
+        else if (x.hi == y.lo) x.hi--;
+    }
+    return x.lo <= x.hi;
+}
+
+// Neither a zero divisor nor INT64_MIN / -1 is possible
+bool Optimizer::divisionSafe(const Range& a, const Range& b) {
+    if (b.lo <= 0 && b.hi >= 0) return false;
+    return !(a.lo == INT64_MIN && b.lo <= -1 && b.hi >= -1);
+}
+
+// Narrow the state at the end of bb for one edge of its conditional goto:
+// the condition is non-zero on the taken edge and zero on the other, and
+// so is the comparison that computed it, if its operands are unchanged.
+// Returns false if the edge can never be taken.
+bool Optimizer::refineBranch(const BasicBlock& bb, bool taken, RangeState& state) {
+    SymbolInfo* cond = quads[bb.last - 1].arg1;
+    if (!isVarSym(cond)) return true;
+    Range zero = {0, 0};
+    Range c = rangeOf(state, cond);
+    if (!narrowRange(c, SymbolInfo::OPERATOR2,
+                     taken ? SymbolInfo::NOT_EQUALS : SymbolInfo::LOGICAL_EQUALS, zero))
+        return false;
+    state[cond->val] = c;
+
+    std::set<uint64_t> redefined;
+    for (uint32_t i = bb.last - 1; i-- > bb.first; ) {
+        const Quad& q = quads[i];
+        SymbolInfo* def = quadDef(q);
+        if (def == nullptr) continue;
+        if (def->val != cond->val) {
+            redefined.insert(def->val);
+            continue;
+        }
+        if (!isBoolQuad(q) || invertedOp(q.op) == nullptr) break;
+        const SymbolInfo* op = taken ? q.op : invertedOp(q.op);
+        Range a = rangeOf(state, q.arg1), b = rangeOf(state, q.arg2);
+        bool aKnown = isVarSym(q.arg1) && q.arg1->val != cond->val &&
+                      redefined.count(q.arg1->val) == 0;
+        bool bKnown = isVarSym(q.arg2) && q.arg2->val != cond->val &&
+                      redefined.count(q.arg2->val) == 0;
+        if (aKnown) {
+            if (!narrowRange(a, op->code, op->val, b)) return false;
+            state[q.arg1->val] = a;
+        }
+        if (bKnown) {
+            uint8_t code = op->code;
+            uint64_t val = op->val;
+            mirrorRelop(code, val);
+            if (!narrowRange(b, code, val, a)) return false;
+            state[q.arg2->val] = b;
+        }
+        break;
+    }
+    return true;
+}
@@ -0,0 +1,127 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "synt.h"
+
+class CFG;
+class PassManager;
+struct BasicBlock;
+
+// Optimization passes over the quads produced by Synt.
+// Passes never modify shared SymbolInfo objects, they only swap pointers.
+class Optimizer {
+public:
+    Optimizer(std::vector<Quad>& quads, const std::vector<LoopLabels>& loops);
+    ~Optimizer();
+    void AddPasses(PassManager& pm, uint8_t level);  // Pipeline of -O<level>
+    void PrintSummary();
+    uint32_t ValueNumbering(); // Local value numbering and dominator-scoped CSE
+    uint32_t CopyPropagation();
+    uint32_t Peephole();
+    uint32_t DeadCodeElimination();
+    uint32_t LoopInvariantCodeMotion();
+    uint32_t InductionVariables();  // Strength reduction and trip counts
+    uint32_t LoopIdioms();          // Counting loops to closed form
+    uint32_t UnrollLoops();
+    uint32_t JumpThreading();
+    uint32_t AllocateTemps();       // Reuse temporary ids based on liveness
+    uint32_t TypeInference();       // Typed print/read, see TaggedVars()
+    uint32_t ValueRanges();         // Unchecked divisions, see VarWidths()
+
+    // Variables whose number/char type is only known at runtime
+    const std::set<uint64_t>& TaggedVars() const { return taggedVars; }
+
+    // Bytes (1, 2, 4 or 8) needed to store every value a variable may hold
+    const std::map<uint64_t, uint8_t>& VarWidths() const { return varWidths; }
+
+    // Iteration counts of counted loops, keyed by the loop's start label id
+    const std::map<uint64_t, int64_t>& TripCounts() const { return tripCounts; }
+private:
+    // (kind, value) - kind 0 = none, 1 = constant, 2 = variable
+    typedef std::pair<uint8_t, uint64_t> Operand;
+    // (op code, op value, left operand, right operand)
+    typedef std::tuple<uint8_t, uint64_t, Operand, Operand> ExprKey;
+
+    // Expressions available at a program point
+    struct AvailTable {
+        std::map<ExprKey, SymbolInfo*> exprs;  // Expression -> variable holding its value
+        std::map<uint64_t, Operand> copies;    // Variable -> operand it was copied from
+    };
+
+    // A while loop as emitted by Synt::stm, located by its labels:
+    //   LABEL start; <condition>; GOTO t end; <body>; GOTO start; LABEL end
+    struct WhileLoop {
+        uint32_t start;  // Index of the start label quad
+        uint32_t end;    // Index of the end label quad
+        SymbolInfo* startLabel;
+        SymbolInfo* endLabel;
+    };
+
+    // Basic induction variable: defined once in the loop as var = var +/- step
+    struct InductionVar {
+        SymbolInfo* var;
+        uint32_t update;  // Index of the updating quad
+        int64_t step;
+    };
+
+    // Static type of each variable, absent means number
+    enum VarTypes { TYPE_NUMBER, TYPE_CHAR, TYPE_DYNAMIC };
+    typedef std::map<uint64_t, uint8_t> TypeState;
+
+    // Values a variable may hold, absent from a RangeState means any value
+    struct Range {
+        int64_t lo;
+        int64_t hi;
+        bool operator==(const Range& o) const { return lo == o.lo && hi == o.hi; }
+        bool operator!=(const Range& o) const { return !(*this == o); }
+    };
+    typedef std::map<uint64_t, Range> RangeState;
+
+    std::vector<Quad>& quads;
+    const std::vector<LoopLabels>& loops;
+    std::map<uint64_t, int64_t> tripCounts;
+    std::vector<std::pair<uint64_t, std::string>> unrollReport;  // Start label, decision
+    uint32_t tempSlots;             // Slots used by AllocateTemps
+    std::set<uint64_t> taggedVars;
+    std::map<uint64_t, uint8_t> varWidths;
+    SymbolInfo* assignOp;
+    uint64_t nextTemp;
+    uint64_t nextLabel;
+    std::map<std::pair<uint8_t, uint64_t>, SymbolInfo*> opCache;
+
+    SymbolInfo* opSym(uint8_t code, uint64_t val);  // Shared operator symbol
+    SymbolInfo* numSym(int64_t val);                 // New number constant
+    SymbolInfo* newTemp();
+    SymbolInfo* newLabel();
+    SymbolInfo* invertedOp(const SymbolInfo* op);
+    std::map<uint64_t, uint32_t> countUses();
+    void removeNops();
+    uint32_t cleanup();
+    std::vector<WhileLoop> findLoops();
+    uint32_t hoistInvariants(const WhileLoop& loop);
+    std::vector<InductionVar> basicInductionVars(const WhileLoop& loop);
+    uint32_t exitTest(const WhileLoop& loop);
+    bool tripCount(const WhileLoop& loop, const std::vector<InductionVar>& ivs, int64_t& trips);
+    uint32_t reduceStrength(const WhileLoop& loop, const std::vector<InductionVar>& ivs);
+    bool replaceCountingLoop(const WhileLoop& loop);
+    std::string unrollLoop(const WhileLoop& loop, bool& unrolled);
+    static uint8_t typeOf(const TypeState& state, uint64_t var);
+    static void applyType(TypeState& state, const Quad& q);
+    static Range rangeOf(const RangeState& state, const SymbolInfo* sym);
+    static Range evalRange(const Quad& q, const RangeState& state);
+    static void applyRange(RangeState& state, const Quad& q);
+    static bool narrowRange(Range& x, uint8_t code, uint64_t op, const Range& y);
+    static bool divisionSafe(const Range& a, const Range& b);
+    bool refineBranch(const BasicBlock& bb, bool taken, RangeState& state);
+    void killVar(AvailTable& table, uint64_t var);
+    Operand canonical(const AvailTable& table, SymbolInfo* sym);
+    std::set<uint64_t> regionDefs(const CFG& cfg, uint32_t block,
+                                  const std::vector<std::set<uint64_t>>& blockDefs, bool& overflow);
+};
+
+#endif
@@ -0,0 +1,123 @@
+#include <iostream>
+#include <algorithm>
+#include "output.h"
+#include "arrayOps.h"
+#include "symbInfo.h"
+#include "settings.h"
+
+Output::Output(uint8_t policy, const Sink& sink) : policy(policy), sink(sink) {
+    buf.resize(sink ? CALLBACK_BUFFER : OUTPUT_BUFFER);
+    used = 0;
+    flushes = 0;
+}
+
+Output::~Output() {
+    Flush();
+}
+
+// Make room for n more bytes
+void Output::full(size_t n) {
+    if (policy != FLUSH_EXIT) Flush();
+    if (used + n > buf.size()) buf.resize(std::max(buf.size() * 2, used + n));
+}
+
+void Output::Text(const char* s) {
+    size_t n = strlen(s);
+    if (used + n > buf.size()) full(n);
+    memcpy(&buf[used], s, n);
+    used += n;
+}
+
+// Digits are produced backwards into a small array and copied once
+void Output::Number(int64_t v) {
+    char digits[20];
+    int32_t n = 0;
+    uint64_t u = v < 0 ? 0 - static_cast<uint64_t>(v) : static_cast<uint64_t>(v);
+    do {
+        digits[n++] = static_cast<char>('0' + u % 10);
+        u /= 10;
+    } while (u != 0);
+    if (used + n + 1 > buf.size()) full(n + 1);
+    if (v < 0) buf[used++] = '-';
+    while (n > 0) buf[used++] = digits[--n];
+}
+
+void Output::number(int64_t v) {
+    if(PRINT_NEWLINE){
+        Text("Output: ");
+        Number(v);
+        Char('\n');
+    }
+    else  Number(v);
+}
+
+void Output::character(int64_t v) {
+    if(PRINT_NEWLINE){
+        Text("Output: ");
+        Char(static_cast<char>(v));
+        Char('\n');
+    }
+    else  Char(static_cast<char>(v));
+}
+
+void Output::PrintNumber(int64_t v) {
+    number(v);
+    printed();
+}
+
+void Output::PrintChar(int64_t v) {
+    character(v);
+    printed();
+}
+
+void Output::PrintLine(int64_t v) {
+    Text("Output: ");
+    Number(v);
+    Char('\n');
+    printed();
+}
+
+void Output::PrintRange(const int64_t* values, const uint8_t* types, uint32_t n) {
+    uint32_t i = 0;
+    while (i < n) {
+        uint32_t run = PRINT_NEWLINE ? 0 : ArrayOps::CharRun(types + i, n - i);
+        if (run == 0) {
+            if (types[i] == SymbolInfo::CHAR) character(values[i]);
+            else number(values[i]);
+            ++i;
+            continue;
+        }
+        if (used + run > buf.size()) full(run);
+        ArrayOps::Narrow(values + i, run, &buf[used]);
+        bool newline = policy == FLUSH_NEWLINE && memchr(&buf[used], '\n', run) != nullptr;
+        used += run;
+        i += run;
+        if (newline) Flush();
+    }
+    printed();
+}
+
+// Goes to whatever std::cout writes to at the time, so redirecting its
+// stream buffer (as -bench and -diff-c do) still captures the output
+void Output::Flush() {
+    if (used == 0) return;
+    std::streambuf* stream = std::cout.rdbuf();
+    if (sink) sink(buf.data(), used);
+    else if (stream != nullptr) {
+        stream->sputn(buf.data(), used);
+        stream->pubsync();
+    }
+    used = 0;
+    ++flushes;
+}
+
+const char* Output::PolicyName(uint8_t policy) {
+    static const char* names[] = { "always", "newline", "read", "full", "exit" };
+    return policy < FLUSH_POLICIES ? names[policy] : "?";
+}
+
+int32_t Output::PolicyByName(const std::string& name) {
+    for (uint8_t p = 0; p < FLUSH_POLICIES; ++p)
+        if (name == PolicyName(p)) return p;
+    return -1;
+}
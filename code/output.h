@@ -0,0 +1,68 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+// When buffered program output is handed to std::cout. A full buffer is
+// always flushed, except with FLUSH_EXIT, and so is everything at exit.
+enum FlushPolicy : uint8_t {
+    FLUSH_ALWAYS,   // After every print, one stream write per print
+    FLUSH_NEWLINE,  // At every newline and before read() and sleep()
+    FLUSH_READ,     // Before read() and sleep(), so prompts and frames show up
+    FLUSH_FULL,     // Only when the buffer is full
+    FLUSH_EXIT,     // Only at exit, the buffer grows as needed
+    FLUSH_POLICIES
+};
+
+// Program output of the VM and the JIT. Prints are collected in a large
+// buffer and written to std::cout's stream buffer in one call per flush,
+// instead of one stream operation per printed char or number.
+class Output {
+public:
+    // Takes each flushed piece of output instead of std::cout
+    typedef std::function<void(const char* data, size_t n)> Sink;
+
+    Output(uint8_t policy, const Sink& sink = Sink());
+    ~Output();  // Flushes
+
+    void Char(char c) {
+        if (used == buf.size()) full(1);
+        buf[used++] = c;
+        if (c == '\n' && policy == FLUSH_NEWLINE) Flush();
+    }
+    void Text(const char* s);
+    void Number(int64_t v);
+
+    // print() in the formats of the interpreter
+    void PrintNumber(int64_t v);
+    void PrintChar(int64_t v);
+    void PrintLine(int64_t v);  // "Output: v" and a newline, for number literals
+    // Array elements, each as its type says, as one print. Runs of chars
+    // are copied into the buffer in bulk.
+    void PrintRange(const int64_t* values, const uint8_t* types, uint32_t n);
+
+    // Before read() and sleep(), which wait for someone
+    void BeforeWait() { if (policy <= FLUSH_READ) Flush(); }
+    void Flush();
+    uint64_t Flushes() const { return flushes; }
+
+    static const char* PolicyName(uint8_t policy);
+    static int32_t PolicyByName(const std::string& name);  // -1 if unknown
+private:
+    std::vector<char> buf;
+    size_t used;
+    uint8_t policy;
+    Sink sink;         // Empty for std::cout
+    uint64_t flushes;  // Writes handed to the stream
+
+    void full(size_t n);
+    void number(int64_t v);     // Format of PrintNumber, without flushing
+    void character(int64_t v);
+    void printed() { if (policy == FLUSH_ALWAYS) Flush(); }
+};
+
+#endif
@@ -0,0 +1,142 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include "pairProfile.h"
+#include "settings.h"
+
+PairProfile::PairProfile() {
+    dispatches = 0;
+    pairs.assign(OP_COUNT * OP_COUNT, 0);
+    triples.assign(OP_COUNT * OP_COUNT * OP_COUNT, 0);
+    Begin();
+}
+
+PairProfile::~PairProfile() {
+    // Destructor
+}
+
+void PairProfile::Begin() {
+    last = nullptr;
+    beforeLast = nullptr;
+}
+
+// Control leaves a sequence only at its last instruction
+static bool fusable(const std::vector<uint8_t>& ops) {
+    for (uint32_t k = 0; k + 1 < ops.size(); ++k)
+        if (ops[k] == OP_JMP || ops[k] == OP_JNZ || ops[k] == OP_HALT || ops[k] >= OP_BASE_COUNT)
+            return false;
+    return ops.back() < OP_BASE_COUNT;
+}
+
+static int32_t opcodeByName(const std::string& name) {
+    for (uint8_t op = 0; op < OP_COUNT; ++op)
+        if (name == Bytecode::OpName(op)) return op;
+    return -1;
+}
+
+// One sequence per line: its opcode names and the count. Names rather than
+// numbers keep old profiles valid when opcodes are added.
+bool PairProfile::Load(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) return true;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::vector<std::string> words;
+        std::string word;
+        while (fields >> word) words.push_back(word);
+        if (words.size() == 2 && words[0] == "dispatches") {
+            dispatches += std::stoull(words[1]);
+            continue;
+        }
+        if (words.size() < 3 || words.size() > 4) continue;
+        std::vector<int32_t> ops;
+        for (uint32_t k = 0; k + 1 < words.size(); ++k) ops.push_back(opcodeByName(words[k]));
+        if (std::find(ops.begin(), ops.end(), -1) != ops.end()) continue;
+        uint64_t count = std::stoull(words.back());
+        if (ops.size() == 2) pairs[ops[0] * OP_COUNT + ops[1]] += count;
+        else triples[(ops[0] * OP_COUNT + ops[1]) * OP_COUNT + ops[2]] += count;
+    }
+    return true;
+}
+
+bool PairProfile::Save(const std::string& path) {
+    std::ofstream out(path);
+    if (!out) return false;
+    out << "dispatches " << dispatches << "\n";
+    for (uint8_t length = 2; length <= 3; ++length)
+        for (const auto& seq : ranked(length, false)) {
+            for (uint8_t op : seq.first) out << Bytecode::OpName(op) << " ";
+            out << seq.second << "\n";
+        }
+    return static_cast<bool>(out);
+}
+
+std::vector<std::pair<std::vector<uint8_t>, uint64_t>> PairProfile::ranked(uint8_t length, bool fusableOnly) {
+    std::vector<std::pair<std::vector<uint8_t>, uint64_t>> result;
+    const std::vector<uint64_t>& counts = length == 2 ? pairs : triples;
+    for (uint32_t i = 0; i < counts.size(); ++i) {
+        if (counts[i] == 0) continue;
+        std::vector<uint8_t> ops(length);
+        uint32_t rest = i;
+        for (int32_t k = length - 1; k >= 0; --k) {
+            ops[k] = rest % OP_COUNT;
+            rest /= OP_COUNT;
+        }
+        if (fusableOnly && !fusable(ops)) continue;
+        result.push_back({ops, counts[i]});
+    }
+    std::stable_sort(result.begin(), result.end(),
+                     [](const auto& x, const auto& y) { return x.second > y.second; });
+    return result;
+}
+
+void PairProfile::PrintTop(uint32_t n) {
+    std::cout << "=== Opcode Pairs (" << dispatches << " dispatches) ===" << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    for (uint8_t length = 2; length <= 3; ++length) {
+        auto seqs = ranked(length, false);
+        for (uint32_t i = 0; i < seqs.size() && i < n; ++i) {
+            std::string name;
+            for (uint8_t op : seqs[i].first) name += std::string(name.empty() ? "" : " ") + Bytecode::OpName(op);
+            std::cout << std::left << std::setw(36) << name << std::right << std::setw(14) << seqs[i].second
+                      << std::setw(7) << (dispatches > 0 ? 100.0 * seqs[i].second / dispatches : 0.0) << "%"
+                      << (fusable(seqs[i].first) ? "" : "  (not fusable)") << std::endl;
+        }
+    }
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout << "=======================" << std::endl << std::endl;
+}
+
+// The most frequent fusable sequences that each ran for at least
+// SUPER_MIN_SHARE of all dispatches
+bool PairProfile::Generate(const std::string& path) {
+    std::ofstream out(path);
+    if (!out) return false;
+    out << "// Generated by \"main -gen-super\" from the opcode counts in " << PAIR_PROFILE_FILE << "\n"
+        << "#ifndef SUPERINSTRUCTIONS_H\n#define SUPERINSTRUCTIONS_H\n\n"
+        << "// Profiled dispatches: " << dispatches << "\n";
+
+    for (uint8_t length = 2; length <= 3; ++length) {
+        uint32_t limit = length == 2 ? SUPER_MAX_PAIRS : SUPER_MAX_TRIPLES;
+        std::vector<std::string> entries;
+        for (const auto& seq : ranked(length, true)) {
+            if (entries.size() >= limit || seq.second < dispatches * SUPER_MIN_SHARE) break;
+            std::string entry = "X(";
+            for (uint32_t k = 0; k < seq.first.size(); ++k)
+                entry += std::string(k > 0 ? ", " : "") + Bytecode::OpName(seq.first[k]);
+            entry += ")";
+            std::ostringstream share;
+            share << std::fixed << std::setprecision(1) << 100.0 * seq.second / dispatches;
+            entries.push_back(entry + std::string(entry.size() < 32 ? 32 - entry.size() : 1, ' ') +
+                              "/* " + share.str() + "% */");
+        }
+        out << "#define " << (length == 2 ? "SUPER_PAIRS(X)" : "SUPER_TRIPLES(X)");
+        for (const std::string& entry : entries) out << " \\\n    " << entry;
+        out << "\n";
+    }
+    out << "\n#endif // SUPERINSTRUCTIONS_H\n";
+    return static_cast<bool>(out);
+}
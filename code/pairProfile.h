@@ -0,0 +1,47 @@
+#ifndef PAIRPROFILE_H
+#define PAIRPROFILE_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include "bytecode.h"
+
+// Counts how often adjacent bytecode instructions run one after the other
+// without a jump in between. Counts add up over runs in a profile file and
+// the most frequent sequences become the superinstructions in
+// superinstructions.h.
+class PairProfile {
+public:
+    PairProfile();
+    ~PairProfile();
+
+    // Called by the VM before every dispatch
+    void Record(const Instr* in) {
+        ++dispatches;
+        if (last != nullptr && in == last + 1) {
+            ++pairs[last->op * OP_COUNT + in->op];
+            if (beforeLast != nullptr && last == beforeLast + 1)
+                ++triples[(beforeLast->op * OP_COUNT + last->op) * OP_COUNT + in->op];
+        }
+        beforeLast = last;
+        last = in;
+    }
+    void Begin();  // A new program starts, nothing ran before it
+
+    uint64_t Dispatches() const { return dispatches; }
+    bool Load(const std::string& path);  // Adds the counts of a profile file, a missing one is empty
+    bool Save(const std::string& path);
+    void PrintTop(uint32_t n);
+    bool Generate(const std::string& path);  // Write the superinstruction header
+private:
+    uint64_t dispatches;
+    std::vector<uint64_t> pairs;    // [first * OP_COUNT + second]
+    std::vector<uint64_t> triples;  // [(first * OP_COUNT + second) * OP_COUNT + third]
+    const Instr* last;
+    const Instr* beforeLast;
+
+    // Opcode sequences by how often they ran, most frequent first
+    std::vector<std::pair<std::vector<uint8_t>, uint64_t>> ranked(uint8_t length, bool fusableOnly);
+};
+
+#endif
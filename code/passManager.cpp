@@ -0,0 +1,163 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <set>
+#include "passManager.h"
+#include "ir.h"
+#include "settings.h"
+
+PassManager::PassManager(std::vector<Quad>& quads) : quads(quads) {
+    // Constructor
+}
+
+PassManager::~PassManager() {
+    // Destructor
+}
+
+void PassManager::AddPass(const std::string& name, std::function<uint32_t()> run) {
+    Pass pass;
+    pass.name = name;
+    pass.run = run;
+    passes.push_back(pass);
+}
+
+bool PassManager::Run() {
+    std::string error;
+    if (DEBUG && !Verify(quads, error)) {
+        std::cout << "VERIFY ERROR: before optimizing: " << error << std::endl;
+        return false;
+    }
+
+    for (const Pass& pass : passes) {
+        PassStats ps;
+        ps.name = pass.name;
+        ps.before = quads.size();
+        auto start = std::chrono::steady_clock::now();
+        ps.changes = pass.run();
+        auto end = std::chrono::steady_clock::now();
+        ps.ms = std::chrono::duration<double, std::milli>(end - start).count();
+        ps.after = quads.size();
+        stats.push_back(ps);
+
+        if (DEBUG && !Verify(quads, error)) {
+            std::cout << "VERIFY ERROR: after " << pass.name << ": " << error << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+void PassManager::PrintStats() {
+    std::cout << "=== Pass Statistics ===" << std::endl;
+    std::cout << std::left << std::setw(22) << "pass" << std::right << std::setw(12) << "time (ms)"
+              << std::setw(10) << "changes" << std::setw(16) << "quads" << std::endl;
+    double total = 0;
+    for (const PassStats& ps : stats) {
+        std::string count = std::to_string(ps.before) + " -> " + std::to_string(ps.after);
+        std::cout << std::left << std::setw(22) << ps.name << std::right << std::setw(12)
+                  << std::fixed << std::setprecision(3) << ps.ms
+                  << std::setw(10) << ps.changes << std::setw(16) << count << std::endl;
+        total += ps.ms;
+    }
+    if (!stats.empty()) {
+        std::string count = std::to_string(stats.front().before) + " -> " +
+                            std::to_string(stats.back().after);
+        std::cout << std::left << std::setw(22) << "total" << std::right << std::setw(12)
+                  << std::fixed << std::setprecision(3) << total
+                  << std::setw(10) << "" << std::setw(16) << count << std::endl;
+    }
+    std::cout << "=======================" << std::endl << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+}
+
+bool PassManager::Verify(const std::vector<Quad>& quads, std::string& error) {
+    std::set<uint64_t> labels, temps, arrays;
+    for (uint32_t i = 0; i < quads.size(); ++i) {
+        const Quad& q = quads[i];
+        if (q.op == nullptr) {
+            if (q.arg1 != nullptr || q.arg2 != nullptr || (q.res != nullptr && !isLabelSym(q.res))) {
+                error = "quad " + std::to_string(i) + ": malformed label";
+                return false;
+            }
+            if (q.res != nullptr && !labels.insert(q.res->val).second) {
+                error = "quad " + std::to_string(i) + ": label L" +
+                        std::to_string(q.res->val - LABEL_BASE) + " defined twice";
+                return false;
+            }
+        }
+        else if (isTempSym(quadDef(q))) {
+            temps.insert(q.res->val);
+        }
+        else if (isOp(q, SymbolInfo::ARRAY, SymbolInfo::DECLARE) && isArraySym(q.res)) {
+            arrays.insert(q.res->val);
+        }
+    }
+
+    auto operand = [](const SymbolInfo* s) { return isConstSym(s) || isVarSym(s); };
+    for (uint32_t i = 0; i < quads.size(); ++i) {
+        const Quad& q = quads[i];
+        if (q.op == nullptr) continue;
+
+        std::string problem;
+        if (isGotoQuad(q)) {
+            if (!isLabelSym(q.res) || labels.count(q.res->val) == 0)
+                problem = "goto to an undefined label";
+            else if (q.arg1 != nullptr && !operand(q.arg1))
+                problem = "bad goto condition";
+        }
+        else if (isBinaryQuad(q)) {
+            if (!operand(q.arg1) || !operand(q.arg2)) problem = "missing operand";
+            else if (!isVarSym(q.res)) problem = "result is not a variable";
+        }
+        else if (isAssignQuad(q)) {
+            if (!operand(q.arg1)) problem = "missing assigned value";
+            else if (!isVarSym(q.res)) problem = "assignment to a non-variable";
+        }
+        else if (isPrintQuad(q)) {
+            if (!operand(q.arg1)) problem = "missing print argument";
+        }
+        else if (isReadQuad(q)) {
+            if (q.res != nullptr && !isVarSym(q.res)) problem = "read into a non-variable";
+        }
+        else if (isOp(q, SymbolInfo::CONSOLE, SymbolInfo::SLEEP)) {
+            if (!operand(q.arg1)) problem = "missing sleep duration";
+        }
+        else if (isOp(q, SymbolInfo::CONSOLE, SymbolInfo::YIELD)) {
+            if (q.arg1 != nullptr) problem = "yield with an argument";
+        }
+        else if (isArrayQuad(q)) {
+            const SymbolInfo* arr = isOp(q, SymbolInfo::ARRAY, SymbolInfo::LOAD) ? q.arg1 : q.res;
+            if (!isArraySym(arr) || arrays.count(arr->val) == 0) problem = "undeclared array";
+            else if (isOp(q, SymbolInfo::ARRAY, SymbolInfo::DECLARE)) {
+                if (q.arg1 == nullptr || q.arg1->code != SymbolInfo::NUMBER) problem = "array size is not a number";
+            }
+            else if (isOp(q, SymbolInfo::ARRAY, SymbolInfo::LOAD)) {
+                if (!operand(q.arg2)) problem = "missing array index";
+                else if (!isVarSym(q.res)) problem = "array load into a non-variable";
+            }
+            else if (isOp(q, SymbolInfo::ARRAY, SymbolInfo::COPY)) {
+                if (!isArraySym(q.arg1) || arrays.count(q.arg1->val) == 0) problem = "copy from an undeclared array";
+            }
+            else if (!operand(q.arg1)) problem = "missing array operand";
+            else if (q.op->val == SymbolInfo::PRINT_RANGE || q.op->val == SymbolInfo::STORE ||
+                     q.op->val == SymbolInfo::STORE_NUMBER || q.op->val == SymbolInfo::STORE_CHAR) {
+                if (!operand(q.arg2)) problem = "missing array operand";
+            }
+        }
+        else {
+            problem = "unknown operator";
+        }
+
+        SymbolInfo* uses[2];
+        uint8_t n = quadUses(q, uses);
+        for (uint8_t k = 0; k < n && problem.empty(); ++k)
+            if (isTempSym(uses[k]) && temps.count(uses[k]->val) == 0)
+                problem = "temporary t" + std::to_string(uses[k]->val - TEMP_BASE) + " is never defined";
+
+        if (!problem.empty()) {
+            error = "quad " + std::to_string(i) + ": " + problem;
+            return false;
+        }
+    }
+    return true;
+}
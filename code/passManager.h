@@ -0,0 +1,41 @@
+#ifndef PASSMANAGER_H
+#define PASSMANAGER_H
+
+#include <functional>
+#include <string>
+#include <vector>
+#include "synt.h"
+
+// Runs registered IR passes in order and records what each one did.
+// In debug builds the quads are verified after every pass.
+class PassManager {
+public:
+    PassManager(std::vector<Quad>& quads);
+    ~PassManager();
+    // A pass returns the number of rewrites it made
+    void AddPass(const std::string& name, std::function<uint32_t()> run);
+    bool Run();          // False if the verifier rejected the output of a pass
+    void PrintStats();   // Per-pass wall time, rewrites and quad counts
+
+    // Structural checks on the quads, the first problem goes to error
+    static bool Verify(const std::vector<Quad>& quads, std::string& error);
+private:
+    struct Pass {
+        std::string name;
+        std::function<uint32_t()> run;
+    };
+
+    struct PassStats {
+        std::string name;
+        double ms;
+        uint32_t changes;
+        uint32_t before;  // Quads before the pass
+        uint32_t after;
+    };
+
+    std::vector<Quad>& quads;
+    std::vector<Pass> passes;
+    std::vector<PassStats> stats;
+};
+
+#endif
@@ -0,0 +1,108 @@
+#include <iostream>
+#include <algorithm>
+#include <thread>
+#include "scheduler.h"
+#include "execPolicy.h"
+#include "settings.h"
+
+Scheduler::Scheduler(uint32_t workers, uint32_t quantum) : workers(workers), quantum(quantum) {
+    if (this->workers == 0) this->workers = std::max(1u, std::thread::hardware_concurrency());
+    if (this->quantum == 0) this->quantum = 1;
+    finished = 0;
+    input = nullptr;
+}
+
+Scheduler::~Scheduler() {
+    for (Green* g : threads) {
+        delete g->executor;
+        delete g;
+    }
+}
+
+void Scheduler::Add(std::vector<Quad>& quads, const std::set<uint64_t>* taggedVars) {
+    Green* g = new Green();
+    g->executor = new Executor(quads);
+    if (taggedVars != nullptr)
+        g->executor->SetTaggedVars(*taggedVars);
+    g->executor->Start();
+    g->stop = SlicePolicy::STOP_NONE;
+    g->slices = 0;
+    threads.push_back(g);
+}
+
+void Scheduler::Run() {
+    input = new Input(true, "");
+    finished = 0;
+    ready.assign(threads.begin(), threads.end());
+    uint32_t n = std::min(workers, static_cast<uint32_t>(threads.size()));
+    std::vector<std::thread> pool;
+    for (uint32_t i = 0; i < n; ++i)
+        pool.emplace_back([this]() { work(); });
+    for (std::thread& t : pool) t.join();
+    delete input;
+    input = nullptr;
+
+    if(DEBUG){
+        std::cout << "\n=== Green Threads (" << n << " workers) ===" << std::endl;
+        for (uint32_t i = 0; i < threads.size(); ++i)
+            std::cout << "thread " << i << ": " << threads[i]->slices << " slices" << std::endl;
+    }
+}
+
+// A worker takes the thread at the front of the run queue, or waits for a
+// sleeping one to become due, and runs one slice of it. Its output goes to
+// the worker's own buffer and is written out before the thread is queued
+// again, so slices of one thread appear in order.
+void Scheduler::work() {
+    Output* out = new Output(FLUSH_EXIT);
+    std::unique_lock<std::mutex> guard(lock);
+    for (;;) {
+        Clock::time_point now = Clock::now();
+        while (!sleeping.empty() && sleeping.begin()->first <= now) {
+            ready.push_back(sleeping.begin()->second);
+            sleeping.erase(sleeping.begin());
+        }
+        if (ready.empty()) {
+            if (finished == threads.size()) break;
+            if (!sleeping.empty()) {
+                Clock::time_point due = sleeping.begin()->first;  // The entry can go while waiting
+                changed.wait_until(guard, due);
+            }
+            else changed.wait(guard);
+            continue;
+        }
+        Green* g = ready.front();
+        ready.pop_front();
+        guard.unlock();
+
+        // A read runs alone in its slice, the input is shared
+        int64_t sleepMs = 0;
+        uint8_t stop;
+        if (g->stop == SlicePolicy::STOP_READ) {
+            std::lock_guard<std::mutex> reading(inputLock);
+            stop = g->executor->Slice(1, out, input, sleepMs);
+        }
+        else stop = g->executor->Slice(quantum, out, input, sleepMs);
+        {
+            std::lock_guard<std::mutex> writing(outputLock);
+            out->Flush();
+        }
+
+        guard.lock();
+        g->stop = stop;
+        ++g->slices;
+        if (stop == SlicePolicy::STOP_NONE) {
+            if (++finished == threads.size()) changed.notify_all();
+        }
+        else if (stop == SlicePolicy::STOP_SLEEP && sleepMs > 0) {
+            sleeping.insert({Clock::now() + std::chrono::milliseconds(sleepMs), g});
+            changed.notify_one();
+        }
+        else {
+            ready.push_back(g);
+            changed.notify_one();
+        }
+    }
+    guard.unlock();
+    delete out;
+}
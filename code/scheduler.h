@@ -0,0 +1,56 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+#include <vector>
+#include "executor.h"
+#include "output.h"
+#include "input.h"
+
+// Runs many programs in one process as green threads: each has its own
+// registers and is interpreted a time slice at a time by a few worker OS
+// threads sharing one run queue. A slice ends at a loop header once the
+// quantum of instructions has run, and before read(), sleep() and yield().
+// A sleeping thread leaves its worker to the others until it is due.
+// Each slice's output is written as one piece once the slice ends, reads
+// share one batch input on stdin, unprompted.
+class Scheduler {
+public:
+    // workers 0 for one per core
+    Scheduler(uint32_t workers, uint32_t quantum);
+    ~Scheduler();
+    // taggedVars as given by the optimizer, nullptr to tag every variable.
+    // The quads must outlive Run.
+    void Add(std::vector<Quad>& quads, const std::set<uint64_t>* taggedVars);
+    void Run();  // Until every program has finished
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Green {
+        Executor* executor;
+        uint8_t stop;      // Why its last slice ended, a SlicePolicy::Stop
+        uint64_t slices;
+    };
+
+    uint32_t workers;
+    uint32_t quantum;
+    std::vector<Green*> threads;
+    std::deque<Green*> ready;                      // Round robin order
+    std::multimap<Clock::time_point, Green*> sleeping;  // By the time they are due
+    uint32_t finished;
+    std::mutex lock;                               // Guards the queues and finished
+    std::condition_variable changed;               // Work was queued or everything finished
+    std::mutex outputLock;                         // One slice's output at a time
+    std::mutex inputLock;                          // One read at a time
+    Input* input;
+
+    void work();  // Loop of a worker OS thread
+};
+
+#endif
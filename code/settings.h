@@ -1,16 +1,34 @@
-// Yordan Yordanov, October 2025
-
-#ifndef SETTINGS_H
-#define SETTINGS_H
-
-#include <cstdint>
-#include <string>
-
-const std::string INPUT_FILE = "program.cmm";
-const uint8_t ALPHABET_SIZE = 94;
-const bool DEBUG = false;
-const bool ERROR = true;
-const bool PRINT_NEWLINE = false;
-const bool RUNTIME_DEBUGGING = false;
-
+// Yordan Yordanov, October 2025
+
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include <cstdint>
+#include <string>
+
+const std::string INPUT_FILE = "program.cmm";
+const uint8_t ALPHABET_SIZE = 96;
+const bool DEBUG = false;
+const bool ERROR = true;
+const bool PRINT_NEWLINE = false;
+const bool RUNTIME_DEBUGGING = false; // start in the step debugger, like -step
+const uint8_t OPT_LEVEL = 2; // default optimization level, -O0/-O1/-O2 override it
+const bool LOOP_IDIOMS = true; // false keeps empty counting loops, e.g. when used as delays
+const uint8_t UNROLL_FACTOR = 4; // copies of a counted loop's body, 1 disables unrolling
+const uint32_t UNROLL_MAX_QUADS = 32; // largest unrolled loop body
+const bool SUPERINSTRUCTIONS = true; // fuse the sequences listed in superinstructions.h
+const std::string PAIR_PROFILE_FILE = "pairs.prof"; // -profile-pairs adds to it, -gen-super reads it
+const uint8_t SUPER_MAX_PAIRS = 8; // superinstructions -gen-super generates
+const uint8_t SUPER_MAX_TRIPLES = 4;
+const double SUPER_MIN_SHARE = 0.01; // of all profiled dispatches
+const uint32_t TIER_HOT_LOOP = 1000; // -tiered compiles once a loop header ran this often
+const uint32_t OUTPUT_BUFFER = 1 << 16; // bytes of program output collected per write
+const uint32_t INPUT_BUFFER = 1 << 16; // bytes read at a time with -batch
+const uint32_t CALLBACK_BUFFER = 1 << 12; // bytes of input and output buffered for read/write callbacks, which cost no system call
+const uint8_t OUTPUT_FLUSH = 2; // FlushPolicy in output.h: 0 always, 1 newline, 2 read, 3 full, 4 exit
+const uint32_t GREEN_QUANTUM = 10000; // instructions a green thread runs before the next loop header switches it out
+const uint32_t GREEN_WORKERS = 0; // OS threads running green threads, 0 for one per core; -workers=N overrides it
+const uint32_t ARRAY_MAX_SIZE = 1 << 20; // elements of one array
+const std::string C_COMPILER = "cc -O2 -fwrapv -w"; // -compile-c builds the generated C with it
+
 #endif // SETTINGS_H
\ No newline at end of file
@@ -0,0 +1,19 @@
+// Generated by "main -gen-super" from the opcode counts in pairs.prof
+#ifndef SUPERINSTRUCTIONS_H
+#define SUPERINSTRUCTIONS_H
+
+// Profiled dispatches: 1808124
+#define SUPER_PAIRS(X) \
+    X(NE, JNZ)                      /* 16.6% */ \
+    X(ADD, ADD)                     /* 16.6% */ \
+    X(DIV_UNCHECKED, ADD)           /* 16.6% */ \
+    X(ADD, NE)                      /* 11.1% */ \
+    X(GE, JNZ)                      /* 5.6% */ \
+    X(ADD, JMP)                     /* 5.6% */
+#define SUPER_TRIPLES(X) \
+    X(DIV_UNCHECKED, ADD, ADD)      /* 16.6% */ \
+    X(ADD, NE, JNZ)                 /* 11.1% */ \
+    X(ADD, ADD, NE)                 /* 11.0% */ \
+    X(ADD, ADD, JMP)                /* 5.5% */
+
+#endif // SUPERINSTRUCTIONS_H
@@ -1,49 +1,63 @@
-// Yordan Yordanov, October 2025
-
-#ifndef SYMBINFO_H
-#define SYMBINFO_H
-
-#include <cstdint>
-
-class SymbolInfo {
-public:
-    SymbolInfo();
-    ~SymbolInfo();
-    uint8_t code;
-    uint64_t val;
-
-    enum IdentifierTypes {
-        VARIABLE, NUMBER, CHAR, LOOP, BOOL,
-        CONSOLE, OPERATOR, OPERATOR2
-    };
-
-    enum Operators {
-        PLUS, MINUS, EQUALS, SLASH, MULTI, 
-        NOT, LESS, MORE, OPEN_BRACKET, 
-        CLOSE_BRACKET, OPEN_CURLY_BRACKET, 
-        CLOSE_CURLY_BRACKET, SEMICOLON, DOT
-    };
-
-    enum Operators2 {
-        LINE_COMMENT, LOGICAL_EQUALS, 
-        NOT_EQUALS, LESS_EQUAL, MORE_EQUAL, 
-        INCREMENT, DECREMENT, AND, OR
-    };
-
-    enum Loops {
-        IF, ELSE, FOR, WHILE, BREAK, 
-        CONTINUE, RETURN
-    };
-    
-    enum Bools {
-        TRUE, FALSE, BOOL_NULL
-    };
-
-    enum Console {
-        READ, PRINT
-    };
-private:
-
-};
-
-#endif // SYMBINFO_H
+// Yordan Yordanov, October 2025
+
+#ifndef SYMBINFO_H
+#define SYMBINFO_H
+
+#include <cstdint>
+
+class SymbolInfo {
+public:
+    SymbolInfo();
+    ~SymbolInfo();
+    uint8_t code;
+    uint64_t val;
+
+    enum IdentifierTypes {
+        VARIABLE, NUMBER, CHAR, LOOP, BOOL,
+        CONSOLE, OPERATOR, OPERATOR2, ARRAY
+    };
+
+    enum Operators {
+        PLUS, MINUS, EQUALS, SLASH, MULTI, 
+        NOT, LESS, MORE, OPEN_BRACKET, 
+        CLOSE_BRACKET, OPEN_CURLY_BRACKET, 
+        CLOSE_CURLY_BRACKET, SEMICOLON, DOT,
+        OPEN_SQUARE_BRACKET, CLOSE_SQUARE_BRACKET, COMMA,
+        // Division whose divisor the optimizer proved non-zero
+        SLASH_UNCHECKED
+    };
+
+    enum Operators2 {
+        LINE_COMMENT, LOGICAL_EQUALS, 
+        NOT_EQUALS, LESS_EQUAL, MORE_EQUAL, 
+        INCREMENT, DECREMENT, AND, OR
+    };
+
+    enum Loops {
+        IF, ELSE, FOR, WHILE, BREAK, 
+        CONTINUE, RETURN
+    };
+    
+    enum Bools {
+        TRUE, FALSE, BOOL_NULL
+    };
+
+    enum Console {
+        READ, PRINT, SLEEP, YIELD,
+        // Typed variants emitted by the optimizer's type inference
+        PRINT_NUMBER, PRINT_CHAR, READ_NUMBER, READ_CHAR
+    };
+
+    // Array keywords and the quads on arrays. In quads an array is a
+    // symbol with code ARRAY and the id of its name as val.
+    enum Arrays {
+        DECLARE, FILL, COPY,
+        LOAD, STORE, PRINT_RANGE,
+        // Typed variants emitted by the optimizer's type inference
+        STORE_NUMBER, STORE_CHAR, FILL_NUMBER, FILL_CHAR
+    };
+private:
+
+};
+
+#endif // SYMBINFO_H
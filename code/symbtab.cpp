@@ -96,17 +96,18 @@ std::string SymbTab::getName(uint8_t code, uint64_t val) const {
     return "";
 }
 
-// 94 characters in total
+// 95 printable characters (space included, for char literals like ' ')
+// plus one shared slot for anything else
 uint8_t SymbTab::charToIndex(char ch) const {
-    if(ch >= '!' && ch <= '~') // printable ASCII
-        return ch - '!';
+    if(ch >= ' ' && ch <= '~') // printable ASCII
+        return ch - ' ';
     else
-        return 255; // invalid character
+        return ALPHABET_SIZE - 1; // other character
 }
 
 char SymbTab::idxToChar(uint8_t idx) const {
-    if(idx <= 93) // printable ASCII
-        return idx + 33;
+    if(idx <= 94) // printable ASCII
+        return idx + 32;
     else
-        return 255; // invalid character
+        return '?'; // other character
 }
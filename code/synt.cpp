@@ -5,13 +5,17 @@
 // semicolon  -> ; { ; }
 // stm        -> ident = expr semicolon | ident = read() semicolon | 
 //               read() semicolon | print ( expr ) semicolon | 
+//               sleep ( expr ) semicolon | yield ( ) semicolon |
+//               array ident [ number ] semicolon | ident [ expr ] = expr semicolon |
+//               fill ( ident , expr ) semicolon | copy ( ident , ident ) semicolon |
+//               print ( ident [ , expr , expr ] ) semicolon |
 //               if ( expr ) stm [ else stm ] | while ( expr ) stm | 
 //               break semicolon | continue semicolon | "{" block_list "}"
 // expr       -> add_expr [ relop add_expr ]
 // add_expr   -> term { + term } | term { - term }
 // relop      -> > | < | == | != | <= | >=
 // term       -> factor { * factor } | factor { / factor }
-// factor     -> ident | number | char | ( expr ) | ident ++ | ident --
+// factor     -> ident | number | char | ( expr ) | ident ++ | ident -- | ident [ expr ]
 
 // Yordan Yordanov, October 2025
 
@@ -42,6 +46,7 @@ Synt::Synt(std::vector<SymbolInfo>& symbolList, std::vector<uint32_t>& lines)
     token = nullptr;
     tempVarCounter = 0;
     labelCounter = 0;
+    messages = &std::cout;
 }
 
 Synt::~Synt(){
@@ -51,11 +56,11 @@ Synt::~Synt(){
 void Synt::SyntaxError(uint8_t errNum, const std::string &error){
     uint32_t line = lines[tokenIdx-1];
     if(error != "" && ERROR){
-        std::cout << "SYNTAX ERROR " << (uint16_t)errNum << ": " << error << " - line " << line << std::endl;
+        *messages << "SYNTAX ERROR " << (uint16_t)errNum << ": " << error << " - line " << line << std::endl;
         throw std::runtime_error("Syntax error 1!");
     }
     else if(ERROR){
-        std::cout << "SYNTAX ERROR 1: Generic error! - line " << line <<  std::endl;
+        *messages << "SYNTAX ERROR 1: Generic error! - line " << line <<  std::endl;
         throw std::runtime_error("Syntax error 2!");
     }
 }
@@ -101,8 +106,20 @@ void Synt::stm(){
         SymbolInfo* var = token;  // Save the variable
         GetToken();
         
+        // Array element: a[index] = expr
+        if (arrays.count(var->val) > 0) {
+            SymbolInfo* index = arrayIndex();
+            if (token->code != SymbolInfo::OPERATOR ||
+                    token->val != SymbolInfo::EQUALS)
+                SyntaxError(3, "\"=\" symbol expected after identifier!" );
+            GetToken();
+            SymbolInfo* exprResult = expr();
+            // Generate quad for the store: value, index -> array
+            emitQuad(genArrayOp(SymbolInfo::STORE), exprResult, index, arrays[var->val].array);
+            semicolon();
+        }
         // Check for increment/decrement as standalone statement (a++ or a--)
-        if (token->code == SymbolInfo::OPERATOR2 && 
+        else if (token->code == SymbolInfo::OPERATOR2 && 
                 (token->val == SymbolInfo::INCREMENT || token->val == SymbolInfo::DECREMENT)) {
             SymbolInfo* op = token;  // Save the operator
             GetToken();
@@ -174,6 +191,36 @@ void Synt::stm(){
                 token->val != SymbolInfo::OPEN_BRACKET) 
             SyntaxError(6, "\"(\" symbol expected after \"print\"!" );
         GetToken();
+        // print(array) or print(array, from, count) prints a range of elements
+        bool element = tokenIdx < symbolList.size() &&
+                       symbolList[tokenIdx].code == SymbolInfo::OPERATOR &&
+                       symbolList[tokenIdx].val == SymbolInfo::OPEN_SQUARE_BRACKET;
+        if (token->code == SymbolInfo::VARIABLE && arrays.count(token->val) > 0 && !element) {
+            const ArrayDecl& decl = arrays[token->val];
+            SymbolInfo* from = new SymbolInfo();
+            from->code = SymbolInfo::NUMBER;
+            from->val = 0;
+            SymbolInfo* count = decl.size;
+            GetToken();
+            if (token->code == SymbolInfo::OPERATOR &&
+                    token->val == SymbolInfo::COMMA) {
+                GetToken();
+                from = expr();
+                if (token->code != SymbolInfo::OPERATOR ||
+                        token->val != SymbolInfo::COMMA)
+                    SyntaxError(33, "\",\" symbol expected after the first element to print!" );
+                GetToken();
+                count = expr();
+            }
+            if (token->code != SymbolInfo::OPERATOR ||
+                    token->val != SymbolInfo::CLOSE_BRACKET)
+                SyntaxError(7, "\")\" symbol expected after \"print(expression\"!" );
+            GetToken();
+            // Generate quad for the range: from, count -> array
+            emitQuad(genArrayOp(SymbolInfo::PRINT_RANGE), from, count, decl.array);
+            semicolon();
+            return;
+        }
         SymbolInfo* exprResult = expr();
         if (token->code != SymbolInfo::OPERATOR || 
                 token->val != SymbolInfo::CLOSE_BRACKET) 
@@ -182,7 +229,95 @@ void Synt::stm(){
         // Generate quad for print: print exprResult
         emitQuad(printOp, exprResult, nullptr, nullptr);
         semicolon();
-    } 
+    }
+    else if (token->code == SymbolInfo::CONSOLE &&
+              token->val == SymbolInfo::SLEEP){ // sleep
+        SymbolInfo* sleepOp = token;  // Save the sleep token
+        GetToken();
+        if (token->code != SymbolInfo::OPERATOR ||
+                token->val != SymbolInfo::OPEN_BRACKET)
+            SyntaxError(19, "\"(\" symbol expected after \"sleep\"!" );
+        GetToken();
+        SymbolInfo* exprResult = expr();
+        if (token->code != SymbolInfo::OPERATOR ||
+                token->val != SymbolInfo::CLOSE_BRACKET)
+            SyntaxError(20, "\")\" symbol expected after \"sleep(expression\"!" );
+        GetToken();
+        // Generate quad for sleep: sleep exprResult milliseconds
+        emitQuad(sleepOp, exprResult, nullptr, nullptr);
+        semicolon();
+    }
+    else if (token->code == SymbolInfo::CONSOLE &&
+              token->val == SymbolInfo::YIELD){ // yield()
+        SymbolInfo* yieldOp = token;  // Save the yield token
+        GetToken();
+        if (token->code != SymbolInfo::OPERATOR ||
+                token->val != SymbolInfo::OPEN_BRACKET)
+            SyntaxError(21, "\"(\" symbol expected after \"yield\"!" );
+        GetToken();
+        if (token->code != SymbolInfo::OPERATOR ||
+                token->val != SymbolInfo::CLOSE_BRACKET)
+            SyntaxError(22, "\")\" symbol expected after \"yield(\"!" );
+        GetToken();
+        // Generate quad for yield
+        emitQuad(yieldOp, nullptr, nullptr, nullptr);
+        semicolon();
+    }
+    else if (token->code == SymbolInfo::ARRAY &&
+              token->val == SymbolInfo::DECLARE){ // array
+        SymbolInfo* declareOp = token;  // Save the array token
+        GetToken();
+        if (token->code != SymbolInfo::VARIABLE)
+            SyntaxError(23, "Array name expected after \"array\"!" );
+        SymbolInfo* var = token;
+        GetToken();
+        if (token->code != SymbolInfo::OPERATOR ||
+                token->val != SymbolInfo::OPEN_SQUARE_BRACKET)
+            SyntaxError(24, "\"[\" symbol expected after array name!" );
+        GetToken();
+        if (token->code != SymbolInfo::NUMBER || token->val == 0 || token->val > ARRAY_MAX_SIZE)
+            SyntaxError(25, "Array size must be a number from 1 to " + std::to_string(ARRAY_MAX_SIZE) + "!" );
+        SymbolInfo* size = token;
+        GetToken();
+        if (token->code != SymbolInfo::OPERATOR ||
+                token->val != SymbolInfo::CLOSE_SQUARE_BRACKET)
+            SyntaxError(26, "\"]\" symbol expected after array size!" );
+        if (arrays.count(var->val) > 0)
+            SyntaxError(27, "Array is already declared!" );
+        GetToken();
+        ArrayDecl decl;
+        decl.array = new SymbolInfo();
+        decl.array->code = SymbolInfo::ARRAY;
+        decl.array->val = var->val;
+        decl.size = size;
+        arrays[var->val] = decl;
+        // Generate quad for the declaration, which zeroes the array: size -> array
+        emitQuad(declareOp, size, nullptr, decl.array);
+        semicolon();
+    }
+    else if (token->code == SymbolInfo::ARRAY &&
+              (token->val == SymbolInfo::FILL || token->val == SymbolInfo::COPY)){ // fill, copy
+        SymbolInfo* bulkOp = token;  // Save the fill or copy token
+        std::string name = token->val == SymbolInfo::FILL ? "fill" : "copy";
+        GetToken();
+        if (token->code != SymbolInfo::OPERATOR ||
+                token->val != SymbolInfo::OPEN_BRACKET)
+            SyntaxError(28, "\"(\" symbol expected after \"" + name + "\"!" );
+        GetToken();
+        SymbolInfo* dst = arrayName();
+        if (token->code != SymbolInfo::OPERATOR ||
+                token->val != SymbolInfo::COMMA)
+            SyntaxError(30, "\",\" symbol expected after array name!" );
+        GetToken();
+        SymbolInfo* src = bulkOp->val == SymbolInfo::FILL ? expr() : arrayName();
+        if (token->code != SymbolInfo::OPERATOR ||
+                token->val != SymbolInfo::CLOSE_BRACKET)
+            SyntaxError(31, "\")\" symbol expected after \"" + name + "(\" arguments!" );
+        GetToken();
+        // Generate quad for fill: value -> array, or copy: source -> array
+        emitQuad(bulkOp, src, nullptr, dst);
+        semicolon();
+    }
     else if (token->code == SymbolInfo::LOOP && 
               token->val == SymbolInfo::IF){ // if
         GetToken();
@@ -269,6 +404,7 @@ void Synt::stm(){
         loopLabels.startLabel = startLabelSym;
         loopLabels.endLabel = endLabelSym;
         loopStack.push(loopLabels);
+        whileLoops.push_back(loopLabels);
         
         // Emit start label
         emitQuad(nullptr, nullptr, nullptr, startLabelSym);  // Label quad
@@ -472,7 +608,13 @@ SymbolInfo* Synt::factor(){
         SymbolInfo* var = token;  // Save the variable
         GetToken();
 
-        if (token != nullptr && token->code == SymbolInfo::OPERATOR2 &&
+        if (arrays.count(var->val) > 0) {
+            SymbolInfo* index = arrayIndex();
+            // Generate quad for the load: array, index -> temp
+            result = genTempVar();
+            emitQuad(genArrayOp(SymbolInfo::LOAD), arrays[var->val].array, index, result);
+        }
+        else if (token != nullptr && token->code == SymbolInfo::OPERATOR2 &&
                  token->val == SymbolInfo::INCREMENT){
             // Generate quad for increment: var = var + 1
             SymbolInfo* one = new SymbolInfo();
@@ -524,6 +666,28 @@ SymbolInfo* Synt::factor(){
     return result;
 }
 
+// [ expr ] after the name of an array
+SymbolInfo* Synt::arrayIndex(){
+    if (token->code != SymbolInfo::OPERATOR ||
+            token->val != SymbolInfo::OPEN_SQUARE_BRACKET)
+        SyntaxError(24, "\"[\" symbol expected after array name!" );
+    GetToken();
+    SymbolInfo* index = expr();
+    if (token->code != SymbolInfo::OPERATOR ||
+            token->val != SymbolInfo::CLOSE_SQUARE_BRACKET)
+        SyntaxError(29, "\"]\" symbol expected after array index!" );
+    GetToken();
+    return index;
+}
+
+SymbolInfo* Synt::arrayName(){
+    if (token->code != SymbolInfo::VARIABLE || arrays.count(token->val) == 0)
+        SyntaxError(32, "Name of a declared array expected!" );
+    SymbolInfo* array = arrays[token->val].array;
+    GetToken();
+    return array;
+}
+
 
 // Semantic analysis helper methods
 SymbolInfo* Synt::genTempVar(){
@@ -539,6 +703,13 @@ uint32_t Synt::genLabel(){
     return labelCounter++;
 }
 
+SymbolInfo* Synt::genArrayOp(uint64_t op){
+    SymbolInfo* arrayOp = new SymbolInfo();
+    arrayOp->code = SymbolInfo::ARRAY;
+    arrayOp->val = op;
+    return arrayOp;
+}
+
 void Synt::emitQuad(SymbolInfo* op, SymbolInfo* arg1, SymbolInfo* arg2, SymbolInfo* res){
     // Broad EMITQUAD debug: show any label result quads
     if (res != nullptr && res->code == SymbolInfo::VARIABLE && res->val >= 10000) {
@@ -557,8 +728,10 @@ void Synt::emitQuad(SymbolInfo* op, SymbolInfo* arg1, SymbolInfo* arg2, SymbolIn
 }
 
 bool Synt::Parse(){
-    GetToken();
-    try{  z(); }
+    try{
+        GetToken();  // Throws at once for an empty program
+        z();
+    }
     catch (const std::runtime_error& e) {
         if (std::string(e.what()) != "Syntax - End of file!")
             return false;
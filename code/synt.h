@@ -3,6 +3,8 @@
 #ifndef SYNT_H
 #define SYNT_H
 
+#include <map>
+#include <ostream>
 #include <vector>
 #include <string>
 #include <stack>
@@ -20,12 +22,19 @@ struct LoopLabels {
     SymbolInfo* endLabel;
 };
 
+struct ArrayDecl {
+    SymbolInfo* array;  // Names the array in quads
+    SymbolInfo* size;
+};
+
 class Synt {
 public:
     Synt(std::vector<SymbolInfo>& symbolList, std::vector<uint32_t>& lines);
     ~Synt();
     bool Parse();
     std::vector<Quad> quads; // Vector to store all generated quads
+    std::vector<LoopLabels> whileLoops; // Start/end labels of every while loop
+    std::ostream* messages; // Where syntax errors go, std::cout by default
 private:
     bool exitCurlyBlock; // Flag to signal that a '}' has been found
     uint32_t inCurlyCount;
@@ -34,6 +43,7 @@ private:
     uint32_t tempVarCounter; // Counter for generating temporary variables
     uint32_t labelCounter;   // Counter for generating labels
     std::stack<LoopLabels> loopStack;  // Stack to track nested loops for break/continue
+    std::map<uint64_t, ArrayDecl> arrays;  // Declared arrays by the id of their name
 
     std::vector<SymbolInfo>& symbolList;
     std::vector<uint32_t>& lines;
@@ -46,12 +56,15 @@ private:
     SymbolInfo* add_expr();  // Returns result of addition expression
     SymbolInfo* term();  // Returns result of term
     SymbolInfo* factor();  // Returns result of factor
+    SymbolInfo* arrayIndex();  // [ expr ], returns the index
+    SymbolInfo* arrayName();   // Name of a declared array, returns its quad symbol
     void GetToken();
     void SyntaxError(uint8_t errNum, const std::string &error);
     
     // Semantic analysis helper methods
     SymbolInfo* genTempVar();  // Generate a temporary variable
     uint32_t genLabel();  // Generate a label number
+    SymbolInfo* genArrayOp(uint64_t op);  // Operator symbol of an array quad
     void emitQuad(SymbolInfo* op, SymbolInfo* arg1, SymbolInfo* arg2, SymbolInfo* res);  // Add quad to vector
 };
 